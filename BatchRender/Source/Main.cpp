@@ -0,0 +1,219 @@
+// Headless batch renderer: runs audio files through the Space Chili engine
+// with the settings of a .spchili preset, several files at a time
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../Source/DelayEngine.h"
+#include "../../Source/HostParameters.h"
+
+#define DEFAULT_RENDER_BLOCK    8192
+#define DEFAULT_MAX_TAIL        30.0
+
+using HostValues = std::array<float, HOST_PARAMETER_COUNT>;
+
+struct RenderSettings {
+    HostValues values;
+    DelayStorage storage{ DelayStorage::FLOAT32 };
+    float bpm{ DEFAULT_BPM };
+    int blockSize{ DEFAULT_RENDER_BLOCK };
+    double maxTailSeconds{ DEFAULT_MAX_TAIL };
+    juce::File outputDir;
+};
+
+// A preset is the plug-in state as XML: one PARAM child per parameter, with
+// the plain (not normalised) value. Parameters it lacks keep their defaults.
+static bool loadPreset(const juce::File& file, RenderSettings& settings)
+{
+    defaultHostParameters(settings.values.data());
+
+    auto xml = juce::XmlDocument::parse(file);
+    if (xml == nullptr) return false;
+
+    for (int i = 0; i < HOST_PARAMETER_COUNT; ++i) {
+        auto name = hostParameterName(static_cast<HostParameter>(i));
+        if (auto param = xml->getChildByAttribute("id", name)) {
+            settings.values[i] = static_cast<float>(param->getDoubleAttribute("value", settings.values[i]));
+        }
+    }
+
+    int format = xml->getIntAttribute("delayStorage", DelayStorage::FLOAT32);
+    settings.storage = format == DelayStorage::FIXED16 || format == DelayStorage::HALF16 ? static_cast<DelayStorage>(format) : DelayStorage::FLOAT32;
+    return true;
+}
+
+static void configure(DSPParameters<float>& params, double sampleRate, int blockSize, int numChannels)
+{
+    params.set(Param::sampleRate, sampleRate);
+    params.set(Param::blockSize, blockSize);
+    params.set(Param::nChannels, numChannels);
+    params.set(Param::nOutputChannels, numChannels);
+    params.set(Param::layout, static_cast<float>(layoutFor(numChannels, numChannels)));
+}
+
+// Average cycles per block of every stage, see StageProfiler.h
+template <typename Stage>
+static juce::String stageReport(const StageProfiler<Stage>& profiler)
+{
+    juce::String report;
+    for (int i = 0; i < static_cast<int>(Stage::count); ++i) {
+        auto stage = static_cast<Stage>(i);
+        report << "\n    " << juce::String(stageName(stage)).paddedRight(' ', 16)
+               << juce::String(profiler.average(stage), 0).paddedLeft(' ', 12) << " cycles/block";
+    }
+    return report;
+}
+
+// Renders input into the output directory under the same name and format,
+// followed by the echo tail. Returns an error message, or an empty string.
+// Profiling builds also describe where the engine spent its cycles.
+static juce::String renderFile(const juce::File& input, const RenderSettings& settings, double& seconds, juce::String& profile)
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(input));
+    if (reader == nullptr) return "cannot read file";
+
+    auto numChannels = static_cast<int>(reader->numChannels);
+    if (numChannels > MAX_CHANNELS) return "more than " + juce::String(MAX_CHANNELS) + " channels";
+
+    auto output = settings.outputDir.getChildFile(input.getFileName());
+    if (output == input) return "output would overwrite the input";
+
+    auto format = formats.findFormatForFileExtension(output.getFileExtension());
+    if (format == nullptr) return "no writer for " + output.getFileExtension();
+
+    auto depths = format->getPossibleBitDepths();
+    auto bits = depths.contains(static_cast<int>(reader->bitsPerSample)) ? static_cast<int>(reader->bitsPerSample) : depths.getLast();
+
+    output.deleteFile();
+    auto stream = output.createOutputStream();
+    if (stream == nullptr) return "cannot create " + output.getFullPathName();
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(
+        stream.get(), reader->sampleRate, static_cast<unsigned int>(numChannels), bits, reader->metadataValues, 0));
+    if (writer == nullptr) return "cannot write " + format->getFormatName();
+    stream.release();
+
+    // Parameters are mapped before prepare() so every smoothed value starts
+    // at the preset instead of ramping from the defaults
+    DSPParameters<float> delayParameters;
+    DSPParameters<float> chorusParameters;
+    configure(delayParameters, reader->sampleRate, settings.blockSize, numChannels);
+    configure(chorusParameters, reader->sampleRate, settings.blockSize, numChannels);
+    delayParameters.set(Param::storage, static_cast<float>(settings.storage));
+    mapHostParameters(settings.values.data(), ALL_PARAMETERS, settings.bpm, delayParameters, chorusParameters);
+
+    auto engine = std::make_unique<DelayEngine<float>>();
+    engine->prepare(delayParameters, chorusParameters);
+    engine->update(delayParameters, chorusParameters);
+
+    juce::AudioBuffer<float> buffer(numChannels, settings.blockSize);
+    auto length = reader->lengthInSamples;
+    auto tailLength = static_cast<juce::int64>(settings.maxTailSeconds * reader->sampleRate);
+
+    // Input first, then silence until the echoes have died away (the engine
+    // goes to sleep) or the tail limit is reached
+    for (juce::int64 position = 0; position < length + tailLength; position += settings.blockSize) {
+        auto n = static_cast<int>(std::min<juce::int64>(settings.blockSize, length + tailLength - position));
+        if (position >= length && engine->tail.isSleeping()) break;
+
+        buffer.clear();
+        if (position < length) {
+            reader->read(&buffer, 0, static_cast<int>(std::min<juce::int64>(n, length - position)), position, true, true);
+        }
+
+        engine->processBlock(buffer.getArrayOfWritePointers(), numChannels, n);
+        if (!writer->writeFromAudioSampleBuffer(buffer, 0, n)) return "write failed";
+    }
+
+    seconds = static_cast<double>(length) / reader->sampleRate;
+    if (StageProfiler<DelayStage>::enabled) {
+        profile = stageReport(engine->delay.getProfile()) + stageReport(engine->chorus.getProfile());
+    }
+    return {};
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: SpaceChiliBatch --preset <file.spchili> [options] <audio files...>\n"
+                 "  --output <dir>       where rendered files go (default: ./rendered)\n"
+                 "  --threads <n>        files rendered in parallel (default: one per core)\n"
+                 "  --block <samples>    samples per processing block (default: " << DEFAULT_RENDER_BLOCK << ")\n"
+                 "  --bpm <tempo>        host tempo for presets synced to the host (default: " << DEFAULT_BPM << ")\n"
+                 "  --max-tail <s>       longest echo tail rendered after the input (default: " << DEFAULT_MAX_TAIL << ")\n"
+                 "Output files keep the name, format and bit depth of their input.\n";
+}
+
+int main (int argc, char* argv[])
+{
+    RenderSettings settings;
+    settings.outputDir = juce::File::getCurrentWorkingDirectory().getChildFile("rendered");
+    juce::String presetPath;
+    int numThreads = juce::SystemStats::getNumCpus();
+    juce::Array<juce::File> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        juce::String arg(argv[i]);
+        auto value = [&] { return i + 1 < argc ? juce::String(argv[++i]) : juce::String(); };
+
+        if (arg == "--preset")          presetPath = value();
+        else if (arg == "--output")     settings.outputDir = juce::File::getCurrentWorkingDirectory().getChildFile(value());
+        else if (arg == "--threads")    numThreads = value().getIntValue();
+        else if (arg == "--block")      settings.blockSize = value().getIntValue();
+        else if (arg == "--bpm")        settings.bpm = value().getFloatValue();
+        else if (arg == "--max-tail")   settings.maxTailSeconds = value().getDoubleValue();
+        else if (arg == "--help" || arg == "-h") { printUsage(); return 0; }
+        else inputs.add(juce::File::getCurrentWorkingDirectory().getChildFile(arg));
+    }
+
+    if (presetPath.isEmpty() || inputs.isEmpty() || numThreads < 1 || settings.blockSize < 1 || settings.bpm <= 0.0f) {
+        printUsage();
+        return 1;
+    }
+
+    auto preset = juce::File::getCurrentWorkingDirectory().getChildFile(presetPath);
+    if (!loadPreset(preset, settings)) {
+        std::cerr << "Cannot load preset " << preset.getFullPathName() << "\n";
+        return 1;
+    }
+    if (settings.outputDir.createDirectory().failed()) {
+        std::cerr << "Cannot create " << settings.outputDir.getFullPathName() << "\n";
+        return 1;
+    }
+
+    std::cout << "Rendering " << inputs.size() << " files on " << numThreads << " threads ("
+              << instructionSetName(activeInstructionSet()) << ")\n";
+
+    // One job per file. Each job owns its engine, reader and writer, so jobs
+    // share nothing but the settings and the console.
+    juce::ThreadPool pool(numThreads);
+    juce::CriticalSection consoleLock;
+    std::atomic<int> failures{ 0 };
+
+    for (const auto& input : inputs) {
+        pool.addJob([&settings, &consoleLock, &failures, input] {
+            auto start = juce::Time::getMillisecondCounterHiRes();
+            double seconds = 0.0;
+            juce::String profile;
+            auto error = renderFile(input, settings, seconds, profile);
+            auto elapsed = (juce::Time::getMillisecondCounterHiRes() - start) * 0.001;
+
+            const juce::ScopedLock lock(consoleLock);
+            if (error.isNotEmpty()) {
+                ++failures;
+                std::cerr << input.getFileName() << ": " << error << "\n";
+            }
+            else {
+                std::cout << input.getFileName() << ": " << juce::String(seconds, 1) << " s in "
+                          << juce::String(elapsed, 2) << " s (" << juce::String(seconds / juce::jmax(elapsed, 0.001), 1) << "x realtime)" << profile << "\n";
+            }
+        });
+    }
+
+    while (pool.getNumJobs() > 0) {
+        juce::Thread::sleep(50);
+    }
+
+    return failures.load() == 0 ? 0 : 1;
+}
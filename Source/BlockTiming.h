@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include "CpuDispatch.h"
+
+// Histogram bins are log spaced, TIMING_BINS_PER_OCTAVE to a doubling. Values
+// outside the range land in the first or last bin.
+#define TIMING_BINS_PER_OCTAVE  4
+#define TIMING_BINS             80
+
+// ns per sample: 1/16 ns to 64 us
+#define NS_PER_SAMPLE_MIN_EXP   -4
+// Share of the block's real time spent processing it: 1/65536 to 16x
+#define UTILISATION_MIN_EXP     -16
+
+// Log-spaced histogram with one writer and any number of readers. The writer
+// owns the counts; readers see each count whole but not all of them at once,
+// which is fine for percentiles.
+template <int MinExponent>
+class LogHistogram
+{
+    std::array<std::atomic<uint32_t>, TIMING_BINS> bins{};
+    std::atomic<uint64_t> count{ 0 };
+    std::atomic<double> maximum{ 0.0 };
+
+    // Single writer: load and store instead of a locked read-modify-write
+    template <typename T, typename V>
+    static void increment(std::atomic<T>& a, V by) {
+        a.store(a.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+public:
+    static int binFor(double value) {
+        if (!(value > 0.0)) return 0;
+        auto bin = static_cast<int>(std::floor((std::log2(value) - MinExponent) * TIMING_BINS_PER_OCTAVE));
+        return bin < 0 ? 0 : (bin >= TIMING_BINS ? TIMING_BINS - 1 : bin);
+    }
+
+    // Upper edge of a bin
+    static double binLimit(int bin) {
+        return std::exp2(MinExponent + static_cast<double>(bin + 1) / TIMING_BINS_PER_OCTAVE);
+    }
+
+    // Writer
+    void add(double value) {
+        increment(bins[binFor(value)], 1u);
+        increment(count, 1u);
+        if (value > maximum.load(std::memory_order_relaxed)) maximum.store(value, std::memory_order_relaxed);
+    }
+
+    // Writer
+    void clear() {
+        for (auto& bin : bins) bin.store(0, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+        maximum.store(0.0, std::memory_order_relaxed);
+    }
+
+    uint64_t size() const { return count.load(std::memory_order_relaxed); }
+    uint32_t operator[](int bin) const { return bins[bin].load(std::memory_order_relaxed); }
+    double max() const { return maximum.load(std::memory_order_relaxed); }
+
+    // Upper edge of the bin holding the given fraction of values, capped at
+    // the largest value seen. 0 when empty.
+    double percentile(double fraction) const {
+        uint64_t total = 0;
+        for (auto& bin : bins) total += bin.load(std::memory_order_relaxed);
+        if (total == 0) return 0.0;
+
+        auto rank = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total)));
+        uint64_t seen = 0;
+        for (int i = 0; i < TIMING_BINS; ++i) {
+            seen += bins[i].load(std::memory_order_relaxed);
+            if (seen >= rank && seen > 0) return std::min(binLimit(i), max());
+        }
+        return max();
+    }
+};
+
+struct TimingSummary {
+    uint64_t blocks;
+    uint64_t overruns;
+    double nsPerSample[3];  // p50, p99, max
+    double utilisation[3];  // p50, p99, max, 1 is the whole block's time
+};
+
+// CPU time of every processed block, against the time the block plays for.
+// The audio thread records, the editor reads; neither waits for the other.
+class BlockTiming
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    LogHistogram<NS_PER_SAMPLE_MIN_EXP> nsPerSample;
+    LogHistogram<UTILISATION_MIN_EXP> utilisation;
+
+    // Audio thread
+    void record(Clock::duration elapsed, int numSamples, double sampleRate) {
+        if (resetRequested.load(std::memory_order_relaxed) && resetRequested.exchange(false, std::memory_order_acquire)) {
+            nsPerSample.clear();
+            utilisation.clear();
+            overrunCount.store(0, std::memory_order_relaxed);
+        }
+        if (numSamples <= 0 || sampleRate <= 0.0) return;
+
+        auto ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        auto used = ns * sampleRate * 1.0e-9 / numSamples;
+
+        nsPerSample.add(ns / numSamples);
+        utilisation.add(used);
+        if (used > 1.0) overrunCount.store(overrunCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Any thread. The audio thread clears the counts before its next record.
+    void reset() {
+        resetRequested.store(true, std::memory_order_release);
+    }
+
+    uint64_t overruns() const { return overrunCount.load(std::memory_order_relaxed); }
+
+    TimingSummary summary() const {
+        return {
+            nsPerSample.size(), overruns(),
+            { nsPerSample.percentile(0.5), nsPerSample.percentile(0.99), nsPerSample.max() },
+            { utilisation.percentile(0.5), utilisation.percentile(0.99), utilisation.max() }
+        };
+    }
+
+    // Summary lines, then one row per bin with its upper edges and counts
+    std::string toCSV() const {
+        auto s = summary();
+        std::string csv = "statistic,ns_per_sample,utilisation\n";
+        csv += "p50," + std::to_string(s.nsPerSample[0]) + "," + std::to_string(s.utilisation[0]) + "\n";
+        csv += "p99," + std::to_string(s.nsPerSample[1]) + "," + std::to_string(s.utilisation[1]) + "\n";
+        csv += "max," + std::to_string(s.nsPerSample[2]) + "," + std::to_string(s.utilisation[2]) + "\n";
+        csv += "blocks," + std::to_string(s.blocks) + ",\n";
+        csv += "overruns," + std::to_string(s.overruns) + ",\n";
+        csv += std::string("instruction_set,") + instructionSetName(activeInstructionSet()) + ",\n\n";
+
+        csv += "bin,ns_per_sample_upto,ns_per_sample_count,utilisation_upto,utilisation_count\n";
+        for (int i = 0; i < TIMING_BINS; ++i) {
+            csv += std::to_string(i) + ","
+                 + std::to_string(nsPerSample.binLimit(i)) + "," + std::to_string(nsPerSample[i]) + ","
+                 + std::to_string(utilisation.binLimit(i)) + "," + std::to_string(utilisation[i]) + "\n";
+        }
+        return csv;
+    }
+
+private:
+    std::atomic<uint64_t> overrunCount{ 0 };
+    std::atomic<bool> resetRequested{ false };
+};
+
+// Times its scope into a BlockTiming
+class ScopedBlockTimer
+{
+    BlockTiming& timing;
+    int numSamples;
+    double sampleRate;
+    BlockTiming::Clock::time_point start{ BlockTiming::Clock::now() };
+
+public:
+    ScopedBlockTimer(BlockTiming& t, int n, double fs) : timing(t), numSamples(n), sampleRate(fs) {}
+
+    ~ScopedBlockTimer() {
+        timing.record(BlockTiming::Clock::now() - start, numSamples, sampleRate);
+    }
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+// Widest bus the delay processes: 7.1.4
+#define MAX_CHANNELS	12
+
+// Bus layouts the DSP has a dedicated kernel for. Chosen once in prepare()
+// and passed to the processing code as template arguments, so each layout is
+// its own instantiation without per-sample channel checks.
+//   SURROUND: 3 to MAX_CHANNELS channels in and out, processed as 4, 8 or 12
+//             lanes with the unused lanes kept silent.
+enum class ChannelLayout { MONO = 0, STEREO = 1, MONO_TO_STEREO = 2, SURROUND = 3 };
+
+inline ChannelLayout layoutFor(int numInputs, int numOutputs) {
+    if (numOutputs <= 1) return ChannelLayout::MONO;
+    if (numOutputs > 2) return ChannelLayout::SURROUND;
+    if (numInputs <= 1) return ChannelLayout::MONO_TO_STEREO;
+    return ChannelLayout::STEREO;
+}
+
+inline int outputsFor(ChannelLayout layout, int numOutputs) {
+    switch (layout) {
+    case ChannelLayout::MONO:     return 1;
+    case ChannelLayout::SURROUND: return numOutputs < MAX_CHANNELS ? numOutputs : MAX_CHANNELS;
+    default:                      return 2;
+    }
+}
+
+// Width of the kernel that processes a layout
+inline int lanesFor(ChannelLayout layout, int numOutputs) {
+    auto channels = outputsFor(layout, numOutputs);
+    if (channels <= 2) return channels;
+    return channels <= 4 ? 4 : (channels <= 8 ? 8 : 12);
+}
@@ -5,8 +5,13 @@
 #include "OnePoleFilter.h"
 #include "Utils.h"
 #include "SimpleDelay.h"
+#include "MultiChannelRingBuffer.h"
+#include "Interpolation.h"
 #include "FilteredParameter.h"
 #include "LFO.h"
+#include "ModulationBank.h"
+#include "ChannelLayout.h"
+#include "StageProfiler.h"
 
 using std::vector;
 using std::array;
@@ -17,19 +22,20 @@ using std::array;
 #define DEFAULT_DL_LENGTH	100.0f
 #define DEFAULT_FILTER_FREQ 3.0f
 
-#define MAX_CHANNELS	2
+#define CHORUS_CHANNELS	2
 #define MAX_DELAYS		2
 
 #define L_PHASE_OFFSET	0.5f
 #define R_PHASE_OFFSET	0.0f
 #define LFO_FREQ		1.0
+// The right LFO runs slightly faster so the voices drift apart
+#define R_RATE_RATIO	1.02f
 
 #define DEFAULT_L_MIN	10.0f
 #define DEFAULT_R_MIN	10.0f
 #define DEFAULT_L_DEPTH	20.0f
 #define DEFAULT_R_DEPTH	20.0f
 
-#define MAX_DELAY_LENGTH			2500.0f
 #define DEFAULT_SAMPLE_RATE			44100
 #define DEFAULT_FEEDBACK_GAIN		0.0f
 #define DEFAULT_DRY_WET_MIX			0.5f
@@ -37,11 +43,34 @@ using std::array;
 
 #define DEFAULT_ATK		50.0f
 
+// Ensemble mode, see Chorus::setVoices()
+#define MAX_CHORUS_VOICES		8
+#define ENSEMBLE_MIN_DELAY		6.0f
+#define ENSEMBLE_DELAY_SPREAD	4.0f
+#define ENSEMBLE_RATE_SPREAD	0.15f
+// Fade of the wet signal on either side of a voice count change
+#define VOICE_SWITCH_TIME		20.0f
+
+// Stages of Chorus::process(), as profiled by StageProfiler: the control rate
+// LFOs and ramps, and the audio rate reads, interpolation and mix
+enum class ChorusStage { modulation, voices, count };
+
+inline const char* stageName(ChorusStage stage) {
+	static const char* names[] = { "chorus lfo", "chorus mix" };
+	return names[static_cast<int>(stage)];
+}
+
+template <typename SampleType>
 struct Chorus {
 
+	// Modulated reads need better than linear interpolation, see Interpolation.h
+	using Interpolator = HermiteInterpolation;
+
+	// The LFO sweeps each voice between its minimum delay and minimum + depth
+	static constexpr float maxDelayLength = std::max(DEFAULT_L_MIN + DEFAULT_L_DEPTH, DEFAULT_R_MIN + DEFAULT_R_DEPTH);
+
 	Chorus() :
 		isOn(false),
-		lfos(),
 		modDepth(0.5f),
 		minDelays(),
 		feedbackGain(DEFAULT_FEEDBACK_GAIN),
@@ -50,29 +79,37 @@ struct Chorus {
 	{}
 
 	void prepare(DSPParameters<float>& params, float lengthInMs = DEFAULT_DL_LENGTH) {
-		auto sampleRate = params["sampleRate"];
-		auto blockSize = params["blockSize"];
-		auto nInputChannels = params["nChannels"];
+		sampleRate = params[Param::sampleRate];
+		auto blockSize = params[Param::blockSize];
+		auto nInputChannels = params[Param::nChannels];
+
+		// Runs after the delay, which already turned mono input into stereo.
+		// Surround buses get the chorus on their first two channels.
+		auto outputs = outputsFor(static_cast<ChannelLayout>(static_cast<int>(params[Param::layout])), static_cast<int>(params[Param::nOutputChannels]));
+		channels = std::min(outputs, CHORUS_CHANNELS);
 
 		amplitude.prepare(sampleRate);
 
-		delayBufferSize = static_cast<int>((lengthToSamples(sampleRate, MAX_DELAY_LENGTH)));
+		delayBufferSize = delayLineSize(sampleRate, maxDelayLength);
 
-		// Initialize LFO and delay array values
-		for (int i = 0; i < MAX_DELAYS; ++i) {
-			ringBuffers[i] = RingBuffer<float>(delayBufferSize);
+		// Initialize LFO and delay array values. The LFO tables are built on
+		// first use, which must not be on the audio thread.
+		LFOTables::get();
+		delayLine.resize(delayBufferSize);
+		for (auto& interpolator : interpolators) {
+			interpolator.prepare();
+			interpolator.reset();
 		}
-		lfos[0].reset(sampleRate, L_PHASE_OFFSET);
-		lfos[0].reset(sampleRate, R_PHASE_OFFSET);
-
 		// Set chorus parameters
 		minDelays[0] = DEFAULT_L_MIN;
 		minDelays[1] = DEFAULT_R_MIN;
-		lfoRate.prepare(sampleRate, DEFAULT_FILTER_FREQUENCY, params["chorusRate"]);
-
-		lfos[0].setFrequency(lfoRate.read());
-		lfos[1].setFrequency(lfoRate.read() * 1.02f);
-		modDepth.prepare(sampleRate, DEFAULT_FILTER_FREQ, params["chorusDepth"]);
+		lfoRate.prepare(sampleRate, DEFAULT_FILTER_FREQUENCY, params[Param::chorusRate]);
+		modDepth.prepare(sampleRate, DEFAULT_FILTER_FREQ, params[Param::chorusDepth]);
+		waveform = static_cast<Waveform>(static_cast<int>(params[Param::chorusWaveform]));
+		switchGain = 1.0f;
+		switchStep = 1.0f / std::max(1.0f, lengthToSamples(sampleRate, VOICE_SWITCH_TIME));
+		setVoices(static_cast<int>(params[Param::voices]));
+		pendingVoices = voices;
 
 		filterL.setSampleRate(sampleRate);
 		filterR.setSampleRate(sampleRate);
@@ -81,64 +118,236 @@ struct Chorus {
 
 	}
 
+	// True when prepare(params) can run without allocating
+	bool fits(DSPParameters<float>& params) {
+		return delayLine.fits(delayLineSize(params[Param::sampleRate], maxDelayLength));
+	}
+
 	void update(DSPParameters<float>& params) {
-		amplitude.setTarget(params["isOn"]);
+		amplitude.setTarget(params[Param::isOn]);
 
-		modDepth.setValue(params["chorusDepth"]);
-		lfoRate.setValue(params["chorusRate"]);
+		modDepth.setValue(params[Param::chorusDepth]);
+		lfoRate.setValue(params[Param::chorusRate]);
+
+		// Applied by process() once the wet signal has faded out
+		pendingVoices = static_cast<int>(params[Param::voices]);
+		pendingVoices = pendingVoices == 4 || pendingVoices == 8 ? pendingVoices : 2;
+
+		auto newWaveform = static_cast<Waveform>(static_cast<int>(params[Param::chorusWaveform]));
+		if (newWaveform != waveform) {
+			waveform = newWaveform;
+			for (int v = 0; v < voices; ++v) {
+				voiceLFOs.setWaveform(v, waveform);
+			}
+		}
+	}
+
+	void clear() {
+		delayLine.clear();
+		for (auto& interpolator : interpolators) {
+			interpolator.reset();
+		}
 	}
 
-	void processBlock(float* const* inputBuffer, int numChannels, int numSamples) {
-		
-		float leftDelaySize{ 0.0f }, rightDelaySize{ 0.0f };
+	void processBlock(SampleType* const* inputBuffer, int numChannels, int numSamples) {
+		auto profiled = profile.timeBlock();
+		if (numChannels < channels) return;
+
+		// A voice count change ends the kernel early; the rest of the block
+		// runs with the new count
+		for (int start = 0; start < numSamples; ) {
+			if (channels == 1) start = dispatch<1>(inputBuffer, start, numSamples);
+			else start = dispatch<2>(inputBuffer, start, numSamples);
+		}
+	}
 
-		if (amplitude.getNextValue() > SILENCE) {
-			for (int s = 0; s < numSamples; ++s) {
-				auto maxDelayL = minDelays[0] + DEFAULT_L_DEPTH;
-				auto maxDelayR = minDelays[1] + DEFAULT_R_DEPTH;
-			
-				float halfL = (maxDelayL - minDelays[0]) / 2.0f;
-				float halfR = (maxDelayR - minDelays[1]) / 2.0f;
-			
-				float midL = halfL + minDelays[0];
-				float midR = halfR + minDelays[1];
+	// Cycles per stage, empty unless built with SPACE_CHILI_PROFILE
+	StageProfiler<ChorusStage>& getProfile() {
+		return profile;
+	}
 
-				auto currentRate = lfoRate.next();
+protected:
+	template <int Channels>
+	int dispatch(SampleType* const* inputBuffer, int start, int numSamples) {
+		switch (voices) {
+		case 8:  return process<Channels, 8>(inputBuffer, start, numSamples);
+		case 4:  return process<Channels, 4>(inputBuffer, start, numSamples);
+		default: return process<Channels, 2>(inputBuffer, start, numSamples);
+		}
+	}
 
-				auto lfoOutputL = lfos[0].updateAndGetNext(currentRate);
-				auto lfoOutputR = lfos[1].updateAndGetNext(currentRate * 1.02f);
+	// Two voices are the classic chorus, one per channel. Ensemble voices get
+	// evenly spread LFO phases, delays, rates and pan positions, and alternate
+	// between the input channels. Resets the LFOs and snaps the delay times,
+	// so it only runs while the wet signal is silent.
+	void setVoices(int count) {
+		voices = count == 4 || count == 8 ? count : 2;
+
+		array<float, MAX_CHORUS_VOICES> offsets, ratios;
+		array<Waveform, MAX_CHORUS_VOICES> waveforms;
+		waveforms.fill(waveform);
+		if (voices == 2) {
+			offsets = { L_PHASE_OFFSET, R_PHASE_OFFSET };
+			ratios = { 1.0f, R_RATE_RATIO };
+			halfDepths = { DEFAULT_L_DEPTH / 2.0f, DEFAULT_R_DEPTH / 2.0f };
+			for (int v = 0; v < 2; ++v) {
+				voiceMids[v] = minDelays[v] + halfDepths[v];
+				voiceChannels[v] = v;
+			}
+		}
+		else {
+			auto gain = std::sqrt(2.0f / voices);
+			for (int v = 0; v < voices; ++v) {
+				auto spread = static_cast<float>(v) / (voices - 1);
+				offsets[v] = static_cast<float>(v) / voices;
+				ratios[v] = 1.0f + ENSEMBLE_RATE_SPREAD * (spread - 0.5f);
+				halfDepths[v] = DEFAULT_L_DEPTH / 2.0f;
+				voiceMids[v] = ENSEMBLE_MIN_DELAY + ENSEMBLE_DELAY_SPREAD * spread + halfDepths[v];
+				voiceChannels[v] = v % channels;
+
+				// Equal-power pan in mirrored pairs from the outside in, so both
+				// sides carry the same power
+				auto pair = static_cast<float>(v / 2) / (voices / 2);
+				auto pan = v % 2 == 0 ? pair * 0.5f : 1.0f - pair * 0.5f;
+				panL[v] = std::cos(pan * 1.57079633f) * gain;
+				panR[v] = std::sin(pan * 1.57079633f) * gain;
+			}
+		}
+		voiceLFOs.reset(sampleRate, offsets.data(), ratios.data(), waveforms.data(), voices);
+
+		// Start every ramp from where the voices are now
+		array<float, MAX_CHORUS_VOICES> targets;
+		voiceTargets(0, targets.data());
+		delayTimes.reset(targets.data(), voices);
+		auto mix = DEFAULT_DRY_WET_MIX * amplitude.read() * switchGain;
+		wetMix.reset(&mix, 1);
+	}
 
-				auto currentModDepth = modDepth.next();
-		
-				auto leftDelayLength = lfoOutputL  * currentModDepth * halfL + midL;
-				auto rightDelayLength = lfoOutputR * currentModDepth * halfR + midR;
+	// Delay time of every voice, in samples, after n more samples
+	template <int Voices = MAX_CHORUS_VOICES>
+	void voiceTargets(int n, float* targets) {
+		auto rate = lfoRate.advance(n);
+		auto depth = modDepth.advance(n);
+		auto samplesPerMs = sampleRate * 0.001f;
+
+		alignas(32) array<float, Voices> lfo;
+		voiceLFOs.template advance<Voices>(rate, n, lfo.data());
+		for (int v = 0; v < Voices; ++v) {
+			targets[v] = (lfo[v] * depth * halfDepths[v] + voiceMids[v]) * samplesPerMs;
+		}
+	}
 
-				leftDelaySize = lengthToSamples(sampleRate, leftDelayLength);
-				rightDelaySize = lengthToSamples(sampleRate, rightDelayLength);
+	// Control rate: LFOs, depth, rate and the on/off fade are evaluated once
+	// per CONTROL_INTERVAL and ramped linearly in between, see ModulationBank.h.
+	// Audio rate only reads the delay time ramps, interpolates and mixes.
+	// A new voice count fades the wet signal out over VOICE_SWITCH_TIME, is
+	// applied when the mix reaches zero, and the wet signal fades back in.
+	// Returns where it stopped: numSamples, or the end of the control
+	// interval at which the voice count changed.
+	//   2 voices: one voice per channel, read through the shared interpolators.
+	//   Ensemble: every voice is one lane; the taps of all voices are gathered
+	//             from the shared interleaved line, the Hermite weights are
+	//             evaluated per lane and the voices are panned into stereo.
+	//             Runs without feedback.
+	// Mono only runs the left voice of the classic chorus.
+	template <int Channels, int Voices>
+	int process(SampleType* const* inputBuffer, int blockStart, int numSamples) {
+		// The fade only moves at control rate below, so its timing does not
+		// depend on the block size. Nothing is heard, so voices switch at once.
+		if (amplitude.isSilent()) {
+			if (pendingVoices != voices) {
+				switchGain = 1.0f;
+				setVoices(pendingVoices);
+			}
+			return numSamples;
+		}
 
-				auto delayReadL = ringBuffers[0].read(leftDelaySize);
-				auto delayReadR = ringBuffers[1].read(rightDelaySize);
+		alignas(32) array<float, Voices> delays, targets, fraction;
+		alignas(32) array<int, Voices> integer;
+		alignas(32) array<SampleType, Voices * INTERPOLATION_TAPS> taps;
+
+		for (int start = blockStart; start < numSamples; start += CONTROL_INTERVAL) {
+			auto n = std::min(CONTROL_INTERVAL, numSamples - start);
+			auto switching = pendingVoices != voices;
+
+			{
+				auto t = profile.time(ChorusStage::modulation);
+				voiceTargets<Voices>(n, targets.data());
+				delayTimes.template rampTo<Voices>(targets.data(), n);
+				switchGain = switching ? std::max(0.0f, switchGain - switchStep * n) : std::min(1.0f, switchGain + switchStep * n);
+				auto mixTarget = DEFAULT_DRY_WET_MIX * amplitude.advance(n) * switchGain;
+				wetMix.template rampTo<1>(&mixTarget, n);
+			}
 
-				float delayInputL, delayInputR;
+			auto t = profile.time(ChorusStage::voices);
+			for (int i = 0; i < n; ++i) {
+				auto s = start + i;
+				delayTimes.template next<Voices>(delays.data());
+				wetMix.template next<1>(&dryWetMix);
 
 				auto leftS = inputBuffer[0][s];
-				auto rightS = inputBuffer[1][s];
-
-				ringBuffers[0].write(leftS + delayReadL * feedbackGain);
-				ringBuffers[1].write(rightS + delayReadR * feedbackGain);
 
-				dryWetMix = DEFAULT_DRY_WET_MIX * amplitude.getNextValue();
+				if constexpr (Voices == 2) {
+					auto delayReadL = delayLine.read(0, delays[0], interpolators[0]);
+
+					if constexpr (Channels == 1) {
+						delayLine.write({ leftS + delayReadL * feedbackGain, 0.0f });
+					}
+					else {
+						auto delayReadR = delayLine.read(1, delays[1], interpolators[1]);
+						auto rightS = inputBuffer[1][s];
+
+						delayLine.write({ leftS + delayReadL * feedbackGain, rightS + delayReadR * feedbackGain });
+
+						inputBuffer[1][s] = rightS * (1.0 - dryWetMix) + delayReadR * dryWetMix;
+					}
+
+					inputBuffer[0][s] = leftS * (1.0 - dryWetMix) + delayReadL * dryWetMix;
+				}
+				else {
+					for (int v = 0; v < Voices; ++v) {
+						integer[v] = static_cast<int>(delays[v]);
+						fraction[v] = delays[v] - integer[v];
+					}
+					delayLine.template gatherTaps<Voices>(voiceChannels.data(), integer.data(), taps.data());
+
+					SampleType wetL = 0, wetR = 0;
+					for (int v = 0; v < Voices; ++v) {
+						// Position from the second tap towards the third, see Interpolation.h
+						auto x = 1.0f - fraction[v];
+						auto x2 = x * x;
+						auto x3 = x2 * x;
+						auto y = taps[v] * (-0.5f * x3 + x2 - 0.5f * x)
+							+ taps[Voices + v] * (1.5f * x3 - 2.5f * x2 + 1.0f)
+							+ taps[2 * Voices + v] * (-1.5f * x3 + 2.0f * x2 + 0.5f * x)
+							+ taps[3 * Voices + v] * (0.5f * x3 - 0.5f * x2);
+						wetL += y * panL[v];
+						wetR += y * panR[v];
+					}
+
+					if constexpr (Channels == 1) {
+						delayLine.write({ leftS, 0.0f });
+						inputBuffer[0][s] = leftS * (1.0 - dryWetMix) + (wetL + wetR) * 0.5f * dryWetMix;
+					}
+					else {
+						auto rightS = inputBuffer[1][s];
+						delayLine.write({ leftS, rightS });
+						inputBuffer[0][s] = leftS * (1.0 - dryWetMix) + wetL * dryWetMix;
+						inputBuffer[1][s] = rightS * (1.0 - dryWetMix) + wetR * dryWetMix;
+					}
+				}
+			}
 
-				inputBuffer[0][s] = leftS * (1.0 - dryWetMix) + delayReadL * dryWetMix;
-				inputBuffer[1][s] = rightS * (1.0 - dryWetMix) + delayReadR * dryWetMix;
-				
+			if (switching && switchGain == 0.0f) {
+				setVoices(pendingVoices);
+				return start + n;
 			}
 		}
-
+		return numSamples;
 	}
 
-protected:
 	bool isOn;
+	int channels{ CHORUS_CHANNELS };
 	float sampleRate;
 	float minDelay;
 	float depth;
@@ -146,17 +355,33 @@ protected:
 	float feedbackGain;
 	float dryWetMix;
 
-	array<RingBuffer<float>, 2> ringBuffers;
+	MultiChannelRingBuffer<SampleType, CHORUS_CHANNELS, INTERPOLATION_GUARD> delayLine;
+	array<Interpolator, CHORUS_CHANNELS> interpolators;
 	array<float, 2> minDelays;
 	array<float, 2> depths;
-	FilteredParameter modDepth;
-	FilteredParameter lfoRate;
+	FilteredParameter<float> modDepth;
+	FilteredParameter<float> lfoRate;
 	LogarithmicFader amplitude;
-	array<LFO, 2> lfos;
+
+	int voices{ 2 };
+	int pendingVoices{ 2 };
+	float switchGain{ 1.0f };
+	float switchStep{ 0.0f };
+	Waveform waveform{ SINE };
+	LFOBank<MAX_CHORUS_VOICES> voiceLFOs;
+	ModulationBank<MAX_CHORUS_VOICES> delayTimes;
+	ModulationBank<1> wetMix;
+	array<float, MAX_CHORUS_VOICES> halfDepths{};
+	array<float, MAX_CHORUS_VOICES> voiceMids{};
+	array<int, MAX_CHORUS_VOICES> voiceChannels{};
+	array<float, MAX_CHORUS_VOICES> panL{};
+	array<float, MAX_CHORUS_VOICES> panR{};
 	
 	// XD
-	OnePoleFilter filterL;
-	OnePoleFilter filterR;
+	OnePoleFilter<SampleType> filterL;
+	OnePoleFilter<SampleType> filterR;
+
+	StageProfiler<ChorusStage> profile;
 
 
 
@@ -0,0 +1,96 @@
+#include "CpuDispatch.h"
+#include "DelayEngine.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// The DSP is header-only and written as fixed-width loops for the compiler to
+// vectorise, so each variant is the same engine render compiled for another
+// target. flatten inlines the whole call tree into the variant, so the ring
+// buffer, interpolation, filters, ducking and mix all get its instructions.
+// The cost is compile time: the flattened variants make this file take over
+// ten times as long to build as the baseline alone. Per-function targets
+// need GCC or Clang on x86. Other builds (MSVC, ARM) only have the baseline.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+ #define DISPATCH_X86 1
+ #define RENDER_VARIANT(isa) __attribute__((target(isa), flatten))
+#else
+ #define DISPATCH_X86 0
+#endif
+
+// The generic instantiations already are the baseline
+template <typename SampleType>
+static void renderBaseline(DelayEngine<SampleType>& engine, SampleType* const* buffer, int numChannels, int numSamples)
+{
+    engine.render(buffer, numChannels, numSamples);
+}
+
+#if DISPATCH_X86
+// No "fma": fused multiply-adds round differently, and every variant should
+// render the same samples. AVX-512 brings its own FMA, so the GCC and Clang
+// exporters build with -ffp-contract=off.
+template <typename SampleType>
+RENDER_VARIANT("avx2") static void renderAVX2(DelayEngine<SampleType>& engine, SampleType* const* buffer, int numChannels, int numSamples)
+{
+    engine.render(buffer, numChannels, numSamples);
+}
+
+template <typename SampleType>
+RENDER_VARIANT("avx512f,avx512vl,avx512bw,avx512dq") static void renderAVX512(DelayEngine<SampleType>& engine, SampleType* const* buffer, int numChannels, int numSamples)
+{
+    engine.render(buffer, numChannels, numSamples);
+}
+#endif
+
+InstructionSet supportedInstructionSet()
+{
+#if DISPATCH_X86
+    // Also checks that the OS saves the wider registers
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl")
+     && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq"))
+        return InstructionSet::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return InstructionSet::AVX2;
+#endif
+    return InstructionSet::Baseline;
+}
+
+InstructionSet activeInstructionSet()
+{
+    static const InstructionSet active = [] {
+        auto set = supportedInstructionSet();
+        if (auto cap = std::getenv(INSTRUCTION_SET_VARIABLE)) {
+            for (auto candidate : { InstructionSet::Baseline, InstructionSet::AVX2, InstructionSet::AVX512 }) {
+                if (std::strcmp(cap, instructionSetName(candidate)) == 0) set = std::min(set, candidate);
+            }
+        }
+        return set;
+    }();
+    return active;
+}
+
+const char* instructionSetName(InstructionSet set)
+{
+    switch (set) {
+    case InstructionSet::AVX512: return "avx512";
+    case InstructionSet::AVX2:   return "avx2";
+    default:                     return "baseline";
+    }
+}
+
+template <typename SampleType>
+EngineRenderer<SampleType> engineRenderer(InstructionSet set)
+{
+#if DISPATCH_X86
+    switch (set) {
+    case InstructionSet::AVX512: return renderAVX512<SampleType>;
+    case InstructionSet::AVX2:   return renderAVX2<SampleType>;
+    default: break;
+    }
+#endif
+    return renderBaseline<SampleType>;
+}
+
+template EngineRenderer<float> engineRenderer<float>(InstructionSet);
+template EngineRenderer<double> engineRenderer<double>(InstructionSet);
@@ -0,0 +1,28 @@
+#pragma once
+
+// Instruction sets the DSP is compiled for. Baseline is whatever the build
+// targets (SSE2 on x86-64); the others are built into the same binary next
+// to it, see CpuDispatch.cpp.
+enum class InstructionSet { Baseline = 0, AVX2 = 1, AVX512 = 2 };
+
+// Environment variable capping the instruction set, for benchmarking:
+// "baseline", "avx2" or "avx512". A set this CPU lacks is never used.
+#define INSTRUCTION_SET_VARIABLE    "SPACE_CHILI_ISA"
+
+// Best set both compiled in and supported by this CPU
+InstructionSet supportedInstructionSet();
+
+// The set the engines render with. Chosen once per process, on first call.
+InstructionSet activeInstructionSet();
+
+const char* instructionSetName(InstructionSet set);
+
+template <typename SampleType> struct DelayEngine;
+
+// Renders one block with an engine, see DelayEngine::render()
+template <typename SampleType>
+using EngineRenderer = void (*)(DelayEngine<SampleType>&, SampleType* const*, int, int);
+
+// Instantiated for float and double in CpuDispatch.cpp
+template <typename SampleType>
+EngineRenderer<SampleType> engineRenderer(InstructionSet set);
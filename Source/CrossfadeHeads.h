@@ -0,0 +1,197 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include "Utils.h"
+
+using std::array;
+
+#define MAX_DELAY_HEADS			4
+#define CROSSFADE_TABLE_SIZE	1024
+#define DEFAULT_CROSSFADE_TIME	50.0f
+
+// Gain curves of a crossfade. Fade-in gain is table(p), fade-out gain is
+// table(1 - p).
+// Linear: the gains sum to one, so heads reading the same signal, as they do
+// after a small delay time change, keep their level. The default.
+// EqualPower: a quarter sine, the squared gains sum to one, so uncorrelated
+// heads keep their power. Correlated ones rise by up to 3 dB mid-fade.
+enum class CrossfadeCurve { Linear = 0, EqualPower = 1 };
+
+class CrossfadeTables
+{
+    array<array<float, CROSSFADE_TABLE_SIZE + 1>, 2> gains;
+
+    CrossfadeTables() {
+        for (int i = 0; i <= CROSSFADE_TABLE_SIZE; ++i) {
+            gains[0][i] = static_cast<float>(i) / CROSSFADE_TABLE_SIZE;
+            gains[1][i] = static_cast<float>(std::sin(1.57079632679489662 * i / CROSSFADE_TABLE_SIZE));
+        }
+    }
+
+public:
+    static const CrossfadeTables& get() {
+        static const CrossfadeTables tables;
+        return tables;
+    }
+
+    const float* operator[] (CrossfadeCurve curve) const {
+        return gains[static_cast<int>(curve)].data();
+    }
+};
+
+// Read heads of one channel of a delay line. Changing the delay time starts a
+// new head and fades it in while every older head fades out from whatever
+// gain it had, so a new target can arrive at any point of a running fade.
+// When all heads are busy, the latest target waits for the running fade to
+// finish. Blocks are processed in two branch-free runs: the part of the block
+// inside the fade, and the part after it. A new curve, see setCurve(), applies
+// from the next fade on.
+template <typename Interpolator>
+class CrossfadeHeads
+{
+    struct Head {
+        float delay{ 0.0f };
+        float startGain{ 1.0f };
+        Interpolator interpolator;
+    };
+
+    // heads[numHeads - 1] is the newest one: fading in, or the only one
+    array<Head, MAX_DELAY_HEADS> heads;
+    int numHeads{ 1 };
+
+    CrossfadeCurve curve{ CrossfadeCurve::Linear };
+    const float* table{ nullptr };
+    int fadeLength{ 1 };
+    int fadePosition{ 0 };
+    float tableScale{ 0.0f };
+
+    bool hasPending{ false };
+    float pendingDelay{ 0.0f };
+
+    int tableIndex(int position) const {
+        return static_cast<int>(position * tableScale);
+    }
+
+    void startFade(float delay) {
+        auto index = tableIndex(fadePosition);
+
+        // Freeze the current gains as the starting point of the fade-outs
+        if (numHeads > 1) {
+            for (int h = 0; h < numHeads - 1; ++h) {
+                heads[h].startGain *= table[CROSSFADE_TABLE_SIZE - index];
+            }
+            heads[numHeads - 1].startGain = table[index];
+        }
+
+        auto& head = heads[numHeads++];
+        head.delay = delay;
+        head.startGain = 1.0f;
+        head.interpolator.reset();
+        fadePosition = 0;
+        table = CrossfadeTables::get()[curve];
+    }
+
+public:
+    void prepare(float sampleRate, float delay, float fadeTime = DEFAULT_CROSSFADE_TIME) {
+        fadeLength = std::max(1, static_cast<int>(lengthToSamples(sampleRate, fadeTime)));
+        tableScale = static_cast<float>(CROSSFADE_TABLE_SIZE) / fadeLength;
+        table = CrossfadeTables::get()[curve];
+
+        for (auto& head : heads) {
+            head.interpolator.prepare();
+        }
+        reset(delay);
+    }
+
+    void reset(float delay) {
+        numHeads = 1;
+        heads[0].delay = delay;
+        heads[0].startGain = 1.0f;
+        heads[0].interpolator.reset();
+        fadePosition = 0;
+        hasPending = false;
+    }
+
+    void setCurve(CrossfadeCurve newCurve) {
+        curve = newCurve;
+    }
+
+    void setTarget(float delay) {
+        if (delay == heads[numHeads - 1].delay) {
+            hasPending = false;
+        }
+        else if (numHeads == MAX_DELAY_HEADS) {
+            pendingDelay = delay;
+            hasPending = true;
+        }
+        else {
+            startFade(delay);
+        }
+    }
+
+    bool isFading() const {
+        return numHeads > 1;
+    }
+
+    // Delay the newest head is at or heading to
+    float getTarget() const {
+        return hasPending ? pendingDelay : heads[numHeads - 1].delay;
+    }
+
+    float longestDelay() const {
+        auto longest = heads[0].delay;
+        for (int h = 1; h < numHeads; ++h) {
+            longest = std::max(longest, heads[h].delay);
+        }
+        return std::max(longest, getTarget());
+    }
+
+    float shortestDelay() const {
+        auto shortest = heads[0].delay;
+        for (int h = 1; h < numHeads; ++h) {
+            shortest = std::min(shortest, heads[h].delay);
+        }
+        return shortest;
+    }
+
+    // Sum of all heads over n samples. Only valid while n is no longer than
+    // the shortest delay, see shortestDelay().
+    template <typename Line, typename T>
+    void read(const Line& delayLine, int channel, T* out, T* scratch, T* gains, int n) {
+        auto& newest = heads[numHeads - 1];
+        delayLine.getReader(channel, newest.delay).nextBlock(out, n, newest.interpolator);
+        if (numHeads == 1) return;
+
+        auto fadeSamples = std::min(n, fadeLength - fadePosition);
+
+        for (int s = 0; s < fadeSamples; ++s) {
+            out[s] *= table[tableIndex(fadePosition + s)];
+        }
+
+        // Older heads only contribute until the end of the fade
+        for (int h = 0; h < numHeads - 1; ++h) {
+            auto& head = heads[h];
+            delayLine.getReader(channel, head.delay).nextBlock(scratch, fadeSamples, head.interpolator);
+            for (int s = 0; s < fadeSamples; ++s) {
+                gains[s] = head.startGain * table[CROSSFADE_TABLE_SIZE - tableIndex(fadePosition + s)];
+            }
+            for (int s = 0; s < fadeSamples; ++s) {
+                out[s] += scratch[s] * gains[s];
+            }
+        }
+
+        fadePosition += fadeSamples;
+        if (fadePosition >= fadeLength) {
+            heads[0] = newest;
+            heads[0].startGain = 1.0f;
+            numHeads = 1;
+            fadePosition = 0;
+            if (hasPending) {
+                hasPending = false;
+                setTarget(pendingDelay);
+            }
+        }
+    }
+};
@@ -1,27 +1,62 @@
 #pragma once
 
-#include <unordered_map>
-#include <string>
-using std::unordered_map;
-using std::string;
+#include <array>
 
+// Every value the processor hands to the DSP, with the value it has until
+// set. Param and the storage of DSPParameters are generated from this list,
+// so a misspelt name does not compile.
+//   X(name, default)
+#define DSP_PARAMETERS(X) \
+    X(sampleRate, 44100.0f) \
+    X(blockSize, 512.0f) \
+    X(nChannels, 2.0f) \
+    X(nOutputChannels, 2.0f) \
+    X(layout, 1.0f) \
+    X(storage, 0.0f) \
+    X(isOn, 1.0f) \
+    X(delayLength, 250.0f) \
+    X(leftDelayLength, 250.0f) \
+    X(rightDelayLength, 250.0f) \
+    X(crossfadeCurve, 0.0f) \
+    X(feedback, 0.0f) \
+    X(mix, 0.5f) \
+    X(pingPong, 0.0f) \
+    X(pingPongRotation, 1.0f) \
+    X(lowPassFreq, 20000.0f) \
+    X(highPassFreq, 20.0f) \
+    X(filterSlope, 0.0f) \
+    X(filterInLoop, 0.0f) \
+    X(ducking, 0.0f) \
+    X(chorusRate, 0.25f) \
+    X(chorusDepth, 0.5f) \
+    X(voices, 2.0f) \
+    X(chorusWaveform, 2.0f)
+
+enum class Param {
+#define DSP_PARAMETER_NAME(name, value) name,
+    DSP_PARAMETERS(DSP_PARAMETER_NAME)
+#undef DSP_PARAMETER_NAME
+    count
+};
+
+// Fixed array indexed by Param: reads and writes are plain indexed loads and
+// stores, never allocate, and are safe to do on the audio thread.
 template <typename T>
 class DSPParameters
 {
-public:
-    unordered_map<string, T> parameters;
+    std::array<T, static_cast<int>(Param::count)> values{
+#define DSP_PARAMETER_DEFAULT(name, value) static_cast<T>(value),
+        DSP_PARAMETERS(DSP_PARAMETER_DEFAULT)
+#undef DSP_PARAMETER_DEFAULT
+    };
 
-    T operator[] (string key) {
-        if (parameters.find(key) != parameters.end()) {
-            return parameters[key];
-        }
-        else {
-            return 1.0f;
-        }
+public:
+    T operator[] (Param key) const {
+        return values[static_cast<int>(key)];
     }
 
-    void set(string key, T value) {
-        parameters[key] = value;
+    template <typename U>
+    void set(Param key, U value) {
+        values[static_cast<int>(key)] = static_cast<T>(value);
     }
-
-};
\ No newline at end of file
+};
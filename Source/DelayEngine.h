@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "StereoDelay.h"
+#include "Chorus.h"
+#include "TailTracker.h"
+#include "DSPParameters.h"
+#include "CpuDispatch.h"
+
+// Everything the audio thread processes, so it can be rebuilt and replaced as
+// one unit when prepareToPlay() needs more memory than the current one has.
+// Sleeps while input and delay lines are silent, see TailTracker.
+template <typename SampleType>
+struct DelayEngine {
+	StereoDelay<SampleType> delay;
+	Chorus<SampleType> chorus;
+	TailTracker tail;
+	float chorusDelaySize{ 0.0f };
+
+	bool fits(DSPParameters<float>& delayParams, DSPParameters<float>& chorusParams) {
+		return delay.fits(delayParams) && chorus.fits(chorusParams);
+	}
+
+	void prepare(DSPParameters<float>& delayParams, DSPParameters<float>& chorusParams) {
+		delay.prepare(delayParams);
+		chorus.prepare(chorusParams);
+		chorusDelaySize = lengthToSamples(chorusParams[Param::sampleRate], Chorus<SampleType>::maxDelayLength);
+		tail.reset();
+	}
+
+	// Either section can be skipped when none of its parameters changed
+	void update(DSPParameters<float>& delayParams, DSPParameters<float>& chorusParams,
+		bool delayChanged = true, bool chorusChanged = true) {
+		if (delayChanged) delay.update(delayParams);
+		if (chorusChanged) chorus.update(chorusParams);
+	}
+
+	// Picked when the engine is built, so the audio thread only makes the call
+	EngineRenderer<SampleType> renderer{ engineRenderer<SampleType>(activeInstructionSet()) };
+
+	void processBlock(SampleType* const* inputBuffer, int numChannels, int numSamples) {
+		renderer(*this, inputBuffer, numChannels, numSamples);
+	}
+
+	// The block itself. CpuDispatch.cpp compiles it, with everything it calls
+	// inlined, once per instruction set; call processBlock() instead.
+	void render(SampleType* const* inputBuffer, int numChannels, int numSamples) {
+		auto inputPeak = TailTracker::peak(inputBuffer, numChannels, numSamples);
+		if (tail.isSleeping()) {
+			if (inputPeak <= SLEEP_THRESHOLD) return;
+			tail.reset();
+		}
+
+		delay.processBlock(inputBuffer, numChannels, numSamples);
+		chorus.processBlock(inputBuffer, numChannels, numSamples);
+
+		tail.setWindow(static_cast<int>(delay.longestDelay() + chorusDelaySize) + INTERPOLATION_TAPS);
+		if (tail.update(inputPeak, delay.getLinePeak(), numSamples)) {
+			delay.clear();
+			chorus.clear();
+		}
+	}
+};
+
+// Owns the active engine and hands it to the audio thread without locks.
+// A replacement is built and prepared by the caller off the audio thread,
+// published with one atomic store, and the old engine is destroyed once the
+// audio thread is no longer inside a block that uses it.
+template <typename Engine>
+class EngineSlot
+{
+	std::unique_ptr<Engine> current;
+	std::atomic<Engine*> active{ nullptr };
+	std::atomic<int> readers{ 0 };
+
+public:
+	// Audio thread: keeps the engine alive for the lifetime of the object
+	class ScopedAccess
+	{
+		EngineSlot& slot;
+		Engine* engine;
+
+	public:
+		ScopedAccess(EngineSlot& s) : slot(s) {
+			slot.readers.fetch_add(1);
+			engine = slot.active.load();
+		}
+
+		~ScopedAccess() {
+			slot.readers.fetch_sub(1);
+		}
+
+		Engine& operator*() const { return *engine; }
+		Engine* operator->() const { return engine; }
+		Engine* get() const { return engine; }
+	};
+
+	// Not for the audio thread. Waits at most one block for the audio thread
+	// to let go of the previous engine before freeing it.
+	void publish(std::unique_ptr<Engine> fresh) {
+		auto retired = std::move(current);
+		current = std::move(fresh);
+		active.store(current.get());
+		while (readers.load() > 0) {
+			std::this_thread::yield();
+		}
+		retired.reset();
+	}
+
+	// Not for the audio thread
+	Engine* get() const {
+		return current.get();
+	}
+};
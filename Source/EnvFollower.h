@@ -11,20 +11,23 @@
 #pragma once
 
 #include <cmath>
+#include <array>
 
 #define SENSITIVITY 10.0f
 
+template <typename T>
 class EnvFollower
 {
-    float attackTime;
-    float releaseTime;
-    float env;
+protected:
+    T attackTime;
+    T releaseTime;
+    T env;
     float sampleRate;
     float sensitivity;
 
-    float computeCoefficient(float t, float sr) {
+    T computeCoefficient(float t, float sr) {
         t /= 1000.0f;
-        return std::exp(-1.0f / (t * sr));
+        return static_cast<T>(std::exp(-1.0f / (t * sr)));
     }
 
 public:
@@ -54,8 +57,8 @@ public:
         setRelease(rt);
     }
 
-    float process(float in) {
-        float rectified = std::fabs(in) * sensitivity;
+    T process(T in) {
+        T rectified = std::fabs(in) * sensitivity;
         if (rectified > env) {
             env = attackTime * (env - rectified) + rectified;
         }
@@ -64,4 +67,30 @@ public:
         }
         return env;
     }
-};
\ No newline at end of file
+};
+
+// Envelope followers for several channels sharing attack and release. The
+// envelopes are lanes, and attack or release is picked with a select instead
+// of a branch, so one frame of channels is one fixed-width SIMD loop.
+template <typename T, int MaxLanes>
+class EnvFollowerBank : public EnvFollower<T>
+{
+    alignas(32) std::array<T, MaxLanes> envelopes{};
+
+public:
+    void prepare(float sr, float at, float rt) {
+        EnvFollower<T>::prepare(sr, at, rt);
+        envelopes.fill(static_cast<T>(0));
+    }
+
+    template <int Lanes>
+    void process(const T* in, T* out) {
+        static_assert(Lanes <= MaxLanes, "Too many lanes");
+        for (int lane = 0; lane < Lanes; ++lane) {
+            T rectified = std::abs(in[lane]) * static_cast<T>(this->sensitivity);
+            T coefficient = rectified > envelopes[lane] ? this->attackTime : this->releaseTime;
+            envelopes[lane] = coefficient * (envelopes[lane] - rectified) + rectified;
+            out[lane] = envelopes[lane];
+        }
+    }
+};
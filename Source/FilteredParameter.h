@@ -10,40 +10,127 @@
 
 #pragma once
 
-#include "OnePoleFilter.h"
+#include <array>
+#include <cmath>
+#include <algorithm>
 
 #define DEFAULT_FILTER_FREQ 3.0f
 #define DEFAULT_SR          44100.0f
 
+// Samples per precomputed stretch of an exponential ramp
+#define SMOOTHING_CHUNK     64
+// A ramp snaps to its target once closer than this, relative to the target
+#define SMOOTHING_EPSILON   1e-5f
+
+enum class Smoothing { Exponential, Linear };
+
+// Parameter smoother that works on whole blocks. fillBlock() writes the next
+// n values of the ramp and advance() skips n values, so smoothing speed only
+// depends on the number of samples processed. Once settled, fills are a plain
+// broadcast of the target.
+//   Exponential: one-pole lowpass with cutoff f, as OnePoleFilter.
+//   Linear:      constant step, reaching the target in 1 / f seconds.
+template <typename T>
 class FilteredParameter
 {
-    OnePoleFilter filter{ DEFAULT_FILTER_FREQ };
-    float sampleRate{DEFAULT_SR};
-    float value{0.0f};
-    float frequency{ DEFAULT_FILTER_FREQ };
+    float sampleRate{ DEFAULT_SR };
+    T target{ 0.0f };
+    T current{ 0.0f };
+
+    Smoothing type{ Smoothing::Exponential };
+
+    // decay[s] = coefficient^(s + 1)
+    std::array<T, SMOOTHING_CHUNK> decay{};
+    int rampLength{ 1 };
+    T step{ 0.0f };
+    int stepsLeft{ 0 };
+
+    void snap() {
+        if (std::abs(current - target) <= SMOOTHING_EPSILON * std::max(std::abs(target), static_cast<T>(1))) {
+            current = target;
+        }
+    }
 
 public:
 
     FilteredParameter(float sr = DEFAULT_SR) : sampleRate(sr) {}
 
-    void prepare(float sr, float f, float v) {
-        filter.setSampleRate(sr);
-        filter.setFrequency(f);
-        value = v;
+    void prepare(float sr, float f, T v, Smoothing smoothing = Smoothing::Exponential) {
+        sampleRate = sr;
+        type = smoothing;
+
+        double coefficient = std::exp(-2.0 * 3.14159265358979323846 * f / sr);
+        double power = 1.0;
+        for (auto& d : decay) {
+            power *= coefficient;
+            d = static_cast<T>(power);
+        }
+        rampLength = std::max(1, static_cast<int>(sr / f));
+
+        target = current = v;
+        stepsLeft = 0;
+    }
+
+    void fillBlock(T* dest, int n) {
+        if (!isSmoothing()) {
+            std::fill(dest, dest + n, current);
+            return;
+        }
+
+        if (type == Smoothing::Linear) {
+            auto k = std::min(n, stepsLeft);
+            for (int s = 0; s < k; ++s) {
+                dest[s] = current + step * (s + 1);
+            }
+            stepsLeft -= k;
+            current = stepsLeft == 0 ? target : current + step * k;
+            std::fill(dest + k, dest + n, current);
+        }
+        else {
+            for (int start = 0; start < n; start += SMOOTHING_CHUNK) {
+                auto m = std::min(SMOOTHING_CHUNK, n - start);
+                auto distance = current - target;
+                for (int s = 0; s < m; ++s) {
+                    dest[start + s] = target + distance * decay[s];
+                }
+                current = target + distance * decay[m - 1];
+            }
+            snap();
+        }
     }
 
-    // Filter then return current value
-    float next() {
-        return filter.process(value);
+    // Skip n samples of the ramp and return the value reached
+    T advance(int n) {
+        if (!isSmoothing()) return current;
+
+        if (type == Smoothing::Linear) {
+            auto k = std::min(n, stepsLeft);
+            stepsLeft -= k;
+            current = stepsLeft == 0 ? target : current + step * k;
+        }
+        else {
+            for (; n > 0; n -= SMOOTHING_CHUNK) {
+                current = target + (current - target) * decay[std::min(n, SMOOTHING_CHUNK) - 1];
+            }
+            snap();
+        }
+        return current;
     }
 
-    // Just return current value
-    float read() {
-        return value;
+    bool isSmoothing() const {
+        return current != target;
     }
 
+    // Target value
+    T read() {
+        return target;
+    }
 
-    void setValue(float v) {
-        value = v;
+    void setValue(T v) {
+        target = v;
+        if (type == Smoothing::Linear) {
+            stepsLeft = rampLength;
+            step = (target - current) / rampLength;
+        }
     }
-};
\ No newline at end of file
+};
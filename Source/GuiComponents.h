@@ -620,3 +620,59 @@ private:
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetMenu);
 };
+
+
+// Block timing readout drawn over the editor. Does not take mouse clicks, so
+// the controls under it keep working.
+class TimingOverlay : public juce::Component, private juce::Timer
+{
+    BlockTiming& timing;
+    juce::Font font;
+
+public:
+    TimingOverlay(BlockTiming& t) : timing(t) {
+        font = juce::Font(juce::Typeface::createSystemTypefaceFor(BinaryData::HackRegular_ttf, BinaryData::HackRegular_ttfSize));
+        setInterceptsMouseClicks(false, false);
+    }
+
+    void paint(juce::Graphics& g) override {
+        auto s = timing.summary();
+        auto line = [](const char* name, const double* v, double scale, int decimals) {
+            return juce::String(name).paddedRight(' ', 8)
+                + juce::String(v[0] * scale, decimals).paddedLeft(' ', 9)
+                + juce::String(v[1] * scale, decimals).paddedLeft(' ', 9)
+                + juce::String(v[2] * scale, decimals).paddedLeft(' ', 9);
+        };
+
+        juce::StringArray lines;
+        lines.add(juce::String("").paddedRight(' ', 8) + "      p50      p99      max");
+        lines.add(line("ns/smp", s.nsPerSample, 1.0, 1));
+        lines.add(line("load %", s.utilisation, 100.0, 1));
+        lines.add("blocks " + juce::String(static_cast<juce::int64>(s.blocks))
+            + "  overruns " + juce::String(static_cast<juce::int64>(s.overruns))
+            + "  " + instructionSetName(activeInstructionSet()));
+
+        g.setColour(Colors::black.withAlpha(0.85f));
+        g.fillRoundedRectangle(getLocalBounds().toFloat(), 4.0f);
+        g.setColour(s.overruns > 0 ? Colors::coloredLight : Colors::altLight);
+        g.setFont(font.withHeight(12.0f * MULT));
+
+        auto area = getLocalBounds().reduced(6 * MULT);
+        auto lineHeight = area.getHeight() / lines.size();
+        for (auto& text : lines) {
+            g.drawText(text, area.removeFromTop(lineHeight), juce::Justification::centredLeft, false);
+        }
+    }
+
+    void visibilityChanged() override {
+        if (isVisible()) startTimerHz(4);
+        else stopTimer();
+    }
+
+private:
+    void timerCallback() override {
+        repaint();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TimingOverlay);
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstdint>
+#include "DelayEngine.h"
+
+// The host parameter table and how its values turn into DSP values. Shared
+// by the plug-in and the batch renderer. Only the ParameterID constants and
+// the parameter layout expand the juce:: ranges, so this header itself needs
+// no JUCE.
+
+enum TempoSource {INTERNAL, HOST};
+enum TimeMode {STRAIGHT, TRIPLETS, DOTTED};
+
+#define DEFAULT_DELAY_LEN       250.0f
+#define DEFAULT_FEEDBACK_GAIN   35.0f
+#define DEFAULT_MIX             35.0f
+#define DEFAULT_LINK            false
+#define DEFAULT_SYNC            false
+#define DEFAULT_BPM             120.0f
+#define DEFAULT_CLOCK_SRC       TempoSource::HOST
+#define DEFAULT_INTERNAL_BPM    120.0f
+#define DEFAULT_SUBDIVISION     3 // 1/8
+#define DEFAULT_TIME_MODE       TimeMode::STRAIGHT
+#define DEFAULT_IS_PINGPONG     0.0f
+#define DEFAULT_PINGPONG_ROTATION   1
+#define DEFAULT_LR_RATIO        1.01f
+#define DEFAULT_LOW_PASS        20000.0f
+#define DEFAULT_HIGH_PASS       20.0f
+#define DEFAULT_FILTER_SLOPE    0 // 6 dB/oct
+#define DEFAULT_FILTER_IN_LOOP  false
+#define DEFAULT_DUCKING         0.0f
+#define DEFAULT_DELAY_ON        true
+
+#define DEFAULT_CHORUS_ON       false
+#define DEFAULT_CHORUS_DEPTH    50.0f
+#define DEFAULT_CHORUS_RATE     0.25f
+#define DEFAULT_CHORUS_VOICES   0 // 2 voices
+
+// Every host parameter, in host order. The parameter IDs, the member
+// pointers, the castParameter() calls and createParameterLayout() are all
+// generated from this one list.
+//   FLOAT(id, name, range, default)
+//   BOOL(id, name, default)
+//   CHOICE(id, name, choices, default)
+//   INT(id, name, min, max, default)
+#define PLUGIN_PARAMETERS(FLOAT, BOOL, CHOICE, INT) \
+    FLOAT(leftDelaySize, "Left (ms)", (juce::NormalisableRange<float>{ 1.0f, 2500.0f, 0.01f, 0.8f }), DEFAULT_DELAY_LEN) \
+    FLOAT(rightDelaySize, "Right (ms)", (juce::NormalisableRange<float>{ 1.0f, 2500.0f, 0.01f, 0.8f }), DEFAULT_DELAY_LEN) \
+    FLOAT(feedback, "Feedback", (juce::NormalisableRange<float>{ 0.0f, 100.0f, 0.1f }), DEFAULT_FEEDBACK_GAIN) \
+    FLOAT(dryWet, "Dry/Wet", (juce::NormalisableRange<float>{ 0.0f, 100.0f, 0.1f }), DEFAULT_DRY_WET) \
+    BOOL(delaySync, "Link", DEFAULT_LINK) \
+    BOOL(syncToBPM, "Sync to BPM", DEFAULT_SYNC) \
+    CHOICE(internalOrHost, "Clock source", (juce::StringArray{ "Internal", "Host" }), DEFAULT_CLOCK_SRC) \
+    FLOAT(internalBPM, "Tempo", (juce::NormalisableRange<float>{ 0.0f, 999.0f, 1.0f }), DEFAULT_BPM) \
+    CHOICE(syncedTimeSubdivisionL, "Time", (juce::StringArray{ "1/1", "1/2", "1/4", "1/8", "1/16", "1/32", "1/64" }), DEFAULT_SUBDIVISION) \
+    CHOICE(syncedTimeSubdivisionR, "Time", (juce::StringArray{ "1/1", "1/2", "1/4", "1/8", "1/16", "1/32", "1/64" }), DEFAULT_SUBDIVISION) \
+    INT(timeModeL, "Time mode left", 0, 2, DEFAULT_TIME_MODE) \
+    INT(timeModeR, "Time mode left", 0, 2, DEFAULT_TIME_MODE) \
+    BOOL(pingPong, "Ping Pong", DEFAULT_IS_PINGPONG) \
+    INT(pingPongRotation, "Ping Pong Rotation", 1, MAX_CHANNELS - 1, DEFAULT_PINGPONG_ROTATION) \
+    FLOAT(leftRightRatio, "Ratio", (juce::NormalisableRange<float>{ 0.75f, 1.25f, 0.01f }), DEFAULT_LR_RATIO) \
+    FLOAT(lowPassFreq, "Lo", (juce::NormalisableRange<float>{ 20.0f, 20000.0f, 0.1f, 0.3f, false }), DEFAULT_LOW_PASS) \
+    FLOAT(highPassFreq, "Hi", (juce::NormalisableRange<float>{ 20.0f, 20000.0f, 0.1f, 0.3f, false }), DEFAULT_HIGH_PASS) \
+    CHOICE(filterSlope, "Filter Slope", (juce::StringArray{ "6 dB/oct", "12 dB/oct", "24 dB/oct" }), DEFAULT_FILTER_SLOPE) \
+    BOOL(filterInLoop, "Filter In Feedback", DEFAULT_FILTER_IN_LOOP) \
+    FLOAT(duckingAmount, "Ducking", (juce::NormalisableRange<float>{ 0.0f, 100.0f, 0.1f }), DEFAULT_DUCKING) \
+    BOOL(delayOn, "Delay On", DEFAULT_DELAY_ON) \
+    BOOL(chorusOn, "Chorus On", DEFAULT_CHORUS_ON) \
+    FLOAT(chorusDepth, "Chorus Depth", (juce::NormalisableRange<float>{ 0.0f, 100.0f, 0.1f }), DEFAULT_CHORUS_DEPTH) \
+    FLOAT(chorusRate, "Chorus Rate", (juce::NormalisableRange<float>{ 0.25f, 0.5f, 0.01f }), DEFAULT_CHORUS_RATE) \
+    CHOICE(chorusVoices, "Chorus Voices", (juce::StringArray{ "2", "4 (Ensemble)", "8 (Ensemble)" }), DEFAULT_CHORUS_VOICES)
+
+// Index of each host parameter, e.g. in a ParameterFrame
+enum class HostParameter {
+#define HOST_PARAMETER_NAME(id, ...) id,
+    PLUGIN_PARAMETERS(HOST_PARAMETER_NAME, HOST_PARAMETER_NAME, HOST_PARAMETER_NAME, HOST_PARAMETER_NAME)
+#undef HOST_PARAMETER_NAME
+    count
+};
+
+#define HOST_PARAMETER_COUNT static_cast<int>(HostParameter::count)
+
+constexpr uint64_t parameterBit(HostParameter parameter) {
+    return uint64_t{ 1 } << static_cast<int>(parameter);
+}
+
+// Everything the delay times are computed from, besides the host tempo
+constexpr uint64_t DELAY_TIME_PARAMETERS =
+    parameterBit(HostParameter::leftDelaySize) | parameterBit(HostParameter::rightDelaySize) |
+    parameterBit(HostParameter::syncToBPM) | parameterBit(HostParameter::internalOrHost) |
+    parameterBit(HostParameter::internalBPM) | parameterBit(HostParameter::leftRightRatio) |
+    parameterBit(HostParameter::syncedTimeSubdivisionL) | parameterBit(HostParameter::syncedTimeSubdivisionR) |
+    parameterBit(HostParameter::timeModeL) | parameterBit(HostParameter::timeModeR);
+
+constexpr uint64_t DELAY_PARAMETERS = DELAY_TIME_PARAMETERS |
+    parameterBit(HostParameter::feedback) | parameterBit(HostParameter::dryWet) |
+    parameterBit(HostParameter::pingPong) | parameterBit(HostParameter::pingPongRotation) |
+    parameterBit(HostParameter::lowPassFreq) | parameterBit(HostParameter::highPassFreq) |
+    parameterBit(HostParameter::filterSlope) | parameterBit(HostParameter::filterInLoop) |
+    parameterBit(HostParameter::duckingAmount) | parameterBit(HostParameter::delayOn);
+
+constexpr uint64_t CHORUS_PARAMETERS =
+    parameterBit(HostParameter::chorusOn) | parameterBit(HostParameter::chorusDepth) |
+    parameterBit(HostParameter::chorusRate) | parameterBit(HostParameter::chorusVoices);
+
+constexpr uint64_t ALL_PARAMETERS = ~uint64_t{ 0 };
+
+// Host parameter values are floats: FLOAT and INT parameters hold their
+// value, BOOL ones 0 or 1, CHOICE ones the index of the choice. The names
+// are the parameter IDs, as stored in the plug-in state and in presets.
+inline const char* hostParameterName(HostParameter parameter) {
+    static const char* names[] = {
+#define HOST_PARAMETER_STRING(id, ...) #id,
+        PLUGIN_PARAMETERS(HOST_PARAMETER_STRING, HOST_PARAMETER_STRING, HOST_PARAMETER_STRING, HOST_PARAMETER_STRING)
+#undef HOST_PARAMETER_STRING
+    };
+    return names[static_cast<int>(parameter)];
+}
+
+inline void defaultHostParameters(float* values) {
+#define FLOAT_DEFAULT(id, name, range, value)       values[static_cast<int>(HostParameter::id)] = static_cast<float>(value);
+#define BOOL_DEFAULT(id, name, value)               values[static_cast<int>(HostParameter::id)] = (value) ? 1.0f : 0.0f;
+#define CHOICE_DEFAULT(id, name, choices, value)    values[static_cast<int>(HostParameter::id)] = static_cast<float>(value);
+#define INT_DEFAULT(id, name, min, max, value)      values[static_cast<int>(HostParameter::id)] = static_cast<float>(value);
+    PLUGIN_PARAMETERS(FLOAT_DEFAULT, BOOL_DEFAULT, CHOICE_DEFAULT, INT_DEFAULT)
+#undef FLOAT_DEFAULT
+#undef BOOL_DEFAULT
+#undef CHOICE_DEFAULT
+#undef INT_DEFAULT
+}
+
+inline float BPM2Ms(int choice, float tempo=120.0f, int timeMode=1) {
+    auto mult = 4.0f / static_cast<float>(1 << (choice));
+    if (timeMode == TimeMode::TRIPLETS) mult *= (2.0f / 3.0f);   
+    if (timeMode == TimeMode::DOTTED) mult *= 1.5f;
+    return static_cast<float>((60000.0f / tempo) * mult);
+}
+
+// Writes the DSP values that follow from the host parameters marked dirty.
+// hostBPM is used when the clock source is the host.
+inline void mapHostParameters(const float* values, uint64_t dirty, float hostBPM,
+    DSPParameters<float>& delayParameters, DSPParameters<float>& chorusParameters) {
+    auto value = [values](HostParameter parameter) { return values[static_cast<int>(parameter)]; };
+    auto apply = [&](DSPParameters<float>& params, HostParameter source, Param target, float scale = 1.0f) {
+        if (dirty & parameterBit(source)) params.set(target, value(source) * scale);
+    };
+
+    if (dirty & DELAY_TIME_PARAMETERS) {
+        bool useHostBPM = value(HostParameter::internalOrHost) == TempoSource::HOST;
+        float bpm = useHostBPM ? hostBPM : value(HostParameter::internalBPM);
+
+        float leftDelaySize;
+        float rightDelaySize;
+
+        if (value(HostParameter::syncToBPM) == 1.0f) {
+            leftDelaySize = BPM2Ms(static_cast<int>(value(HostParameter::syncedTimeSubdivisionL)), bpm,
+                static_cast<int>(value(HostParameter::timeModeL)));
+            rightDelaySize = BPM2Ms(static_cast<int>(value(HostParameter::syncedTimeSubdivisionR)), bpm,
+                static_cast<int>(value(HostParameter::timeModeR)));
+        }
+
+        else {
+            leftDelaySize = value(HostParameter::leftDelaySize);
+            rightDelaySize = value(HostParameter::rightDelaySize);
+        }
+
+        rightDelaySize *= value(HostParameter::leftRightRatio);
+
+        delayParameters.set(Param::leftDelayLength, leftDelaySize);
+        delayParameters.set(Param::rightDelayLength, rightDelaySize);
+    }
+
+    apply(delayParameters, HostParameter::feedback, Param::feedback, 0.01f);
+    apply(delayParameters, HostParameter::dryWet, Param::mix, 0.01f);
+    apply(delayParameters, HostParameter::pingPong, Param::pingPong);
+    apply(delayParameters, HostParameter::pingPongRotation, Param::pingPongRotation);
+    apply(delayParameters, HostParameter::lowPassFreq, Param::lowPassFreq);
+    apply(delayParameters, HostParameter::highPassFreq, Param::highPassFreq);
+    apply(delayParameters, HostParameter::filterSlope, Param::filterSlope);
+    apply(delayParameters, HostParameter::filterInLoop, Param::filterInLoop);
+    apply(delayParameters, HostParameter::duckingAmount, Param::ducking, 0.01f);
+    apply(delayParameters, HostParameter::delayOn, Param::isOn);
+
+    apply(chorusParameters, HostParameter::chorusDepth, Param::chorusDepth, 0.01f);
+    apply(chorusParameters, HostParameter::chorusRate, Param::chorusRate);
+    apply(chorusParameters, HostParameter::chorusOn, Param::isOn);
+    if (dirty & parameterBit(HostParameter::chorusVoices)) {
+        chorusParameters.set(Param::voices, 2 << static_cast<int>(value(HostParameter::chorusVoices)));
+    }
+}
@@ -1,55 +1,120 @@
 #pragma once
 #include <cmath>
+#include <array>
+#include <algorithm>
 
 const float TWO_PI{ 6.2831853071795864f };
 
+// Samples per cycle of the LFO tables
+#define LFO_TABLE_SIZE  2048
+// Harmonics in the band-limited saw and square tables. LFO rates stay below a
+// few tens of Hz, so even the top harmonic is far from Nyquist.
+#define LFO_HARMONICS   64
+
 enum Waveform {
     SINE = 2, SAW = 1, SQUARE = 3, SAW_BL = 4
 };
 
-class LFO
+// One cycle of each waveform, with guard points at the end so linear
+// interpolation never wraps, even when float rounding puts a phase just below
+// 1 on the last index. Saw and square are summed from LFO_HARMONICS partials
+// and scaled to a peak of 1, so the steps are smooth enough not to click when
+// they modulate a delay time. The plain SAW table is a straight ramp, which
+// interpolates exactly. Built on first use, which must not be on the audio
+// thread.
+class LFOTables
 {
-public:
-    float amplitude;
-    float phase{0.0f};
-    float phaseOffset;
-    float inc;
-    float sampleRate{44100.0f};
-    float freq;
-    Waveform waveform{ SINE };
-
-    int sampleIndex{0};
-    float sin0, sin1, dsin;
-
-    void reset(float sr, float offset) {
-        sampleRate = sr;
-        sampleIndex = 0;
-        phaseOffset = offset;
-    }
+    std::array<std::array<float, LFO_TABLE_SIZE + 2>, 4> tables;
 
-    float sine(float p) {
-        return std::sin(TWO_PI * (phase + phaseOffset));
+    LFOTables() {
+        auto& sine = tables[0];
+        auto& saw = tables[1];
+        auto& square = tables[2];
+        auto& ramp = tables[3];
+
+        double sawPeak = 0.0, squarePeak = 0.0;
+        for (int i = 0; i <= LFO_TABLE_SIZE + 1; ++i) {
+            double x = 6.283185307179586 * i / LFO_TABLE_SIZE;
+            double sawSum = 0.0, squareSum = 0.0;
+            for (int k = 1; k <= LFO_HARMONICS; ++k) {
+                // Rising saw, -1 at phase 0 as the naive one
+                sawSum -= std::sin(k * x) / k;
+                if (k % 2 == 1) squareSum += std::sin(k * x) / k;
+            }
+            sine[i] = static_cast<float>(std::sin(x));
+            saw[i] = static_cast<float>(sawSum);
+            square[i] = static_cast<float>(squareSum);
+            ramp[i] = static_cast<float>(2.0 * i / LFO_TABLE_SIZE - 1.0);
+            sawPeak = std::max(sawPeak, std::abs(sawSum));
+            squarePeak = std::max(squarePeak, std::abs(squareSum));
+        }
+        for (int i = 0; i <= LFO_TABLE_SIZE + 1; ++i) {
+            saw[i] = static_cast<float>(saw[i] / sawPeak);
+            square[i] = static_cast<float>(square[i] / squarePeak);
+        }
     }
 
-    float nextSample() {
+public:
+    static const LFOTables& get() {
+        static const LFOTables instance;
+        return instance;
+    }
 
-        phase += inc;
+    const float* operator[] (Waveform waveform) const {
+        switch (waveform) {
+        case SAW_BL: return tables[1].data();
+        case SQUARE: return tables[2].data();
+        case SAW:    return tables[3].data();
+        default:     return tables[0].data();
+        }
+    }
+};
 
-        float output = 0.0f;
-        output = sine(phase);
-        sampleIndex += 1;
+// LFOs side by side as lanes, each with its own waveform, phase offset and
+// rate ratio against a shared rate. advance() moves all of them on by n
+// samples in a fixed-width loop, so they can run at control rate, see
+// ModulationBank.h.
+template <int MaxLanes>
+class LFOBank
+{
+    alignas(32) std::array<float, MaxLanes> phases{};
+    alignas(32) std::array<float, MaxLanes> ratios{};
+    std::array<const float*, MaxLanes> tables{};
+    float sampleRate{ 44100.0f };
 
-        return output;
+public:
+    void reset(float sr, const float* offsets, const float* rateRatios, const Waveform* waveforms, int lanes) {
+        sampleRate = sr;
+        for (int lane = 0; lane < lanes; ++lane) {
+            phases[lane] = offsets[lane] - std::floor(offsets[lane]);
+            ratios[lane] = rateRatios[lane];
+            tables[lane] = LFOTables::get()[waveforms[lane]];
+        }
+        // Unused lanes still run in the fixed-width loop
+        for (int lane = lanes; lane < MaxLanes; ++lane) {
+            tables[lane] = LFOTables::get()[SINE];
+        }
     }
 
-    void setFrequency(float f) {
-        freq = f;
-        inc = f / sampleRate;
+    // Keeps the lane's phase, so the new waveform carries on from where the
+    // old one was in its cycle
+    void setWaveform(int lane, Waveform waveform) {
+        tables[lane] = LFOTables::get()[waveform];
     }
 
-    float updateAndGetNext(float f) {
-        setFrequency(f);
-        return nextSample();
-    }
+    template <int Lanes>
+    void advance(float rate, int n, float* out) {
+        static_assert(Lanes <= MaxLanes, "Too many lanes");
+        auto inc = rate * n / sampleRate;
+        for (int lane = 0; lane < Lanes; ++lane) {
+            auto p = phases[lane] + inc * ratios[lane];
+            p -= static_cast<int>(p);
+            phases[lane] = p;
 
-};
\ No newline at end of file
+            auto table = tables[lane];
+            auto position = p * LFO_TABLE_SIZE;
+            auto index = static_cast<int>(position);
+            out[lane] = table[index] + (position - index) * (table[index + 1] - table[index]);
+        }
+    }
+};
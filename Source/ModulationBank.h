@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+
+// Samples between two evaluations of the modulators
+#define CONTROL_INTERVAL    16
+
+// Control-rate layer for modulation. Modulators (LFOs, smoothed parameters,
+// faders) are evaluated once per control interval into target values, and
+// the bank ramps each lane linearly from where it is to its target over the
+// interval. Audio-rate code then only reads the ramps. Lanes are independent
+// destinations, e.g. the delay time of each chorus voice.
+template <int MaxLanes>
+class ModulationBank
+{
+    alignas(32) std::array<float, MaxLanes> values{};
+    alignas(32) std::array<float, MaxLanes> steps{};
+
+public:
+    // Jump straight to the given values, without a ramp
+    void reset(const float* targets, int lanes) {
+        for (int lane = 0; lane < lanes; ++lane) {
+            values[lane] = targets[lane];
+            steps[lane] = 0.0f;
+        }
+    }
+
+    // Ramp towards targets over the next n samples
+    template <int Lanes>
+    void rampTo(const float* targets, int n) {
+        static_assert(Lanes <= MaxLanes, "Too many lanes");
+        auto scale = 1.0f / n;
+        for (int lane = 0; lane < Lanes; ++lane) {
+            steps[lane] = (targets[lane] - values[lane]) * scale;
+        }
+    }
+
+    // Values for the next sample
+    template <int Lanes>
+    void next(float* out) {
+        for (int lane = 0; lane < Lanes; ++lane) {
+            values[lane] += steps[lane];
+            out[lane] = values[lane];
+        }
+    }
+
+    // The next n values of one lane, without moving on, see advance()
+    void fill(int lane, float* out, int n) const {
+        auto value = values[lane];
+        auto step = steps[lane];
+        for (int s = 0; s < n; ++s) {
+            out[s] = value + step * static_cast<float>(s + 1);
+        }
+    }
+
+    // Move every lane on by n samples
+    template <int Lanes>
+    void advance(int n) {
+        static_assert(Lanes <= MaxLanes, "Too many lanes");
+        for (int lane = 0; lane < Lanes; ++lane) {
+            values[lane] += steps[lane] * static_cast<float>(n);
+        }
+    }
+
+    // True when no lane is ramping
+    template <int Lanes>
+    bool isSettled() const {
+        static_assert(Lanes <= MaxLanes, "Too many lanes");
+        for (int lane = 0; lane < Lanes; ++lane) {
+            if (steps[lane] != 0.0f) return false;
+        }
+        return true;
+    }
+
+    float operator[] (int lane) const {
+        return values[lane];
+    }
+};
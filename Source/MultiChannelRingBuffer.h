@@ -0,0 +1,268 @@
+#pragma once
+
+#include "Utils.h"
+#include "RingBuffer.h"
+#include "SampleStorage.h"
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+using std::array;
+using std::vector;
+
+// Ring buffer storing all channels of a frame next to each other
+// (L0 R0 L1 R1 ...), so one write touches a single cache line and a frame read
+// at a common delay is a single NumChannels-wide load.
+// GuardSize mirrors the first frames past the end, as in RingBuffer.
+// Storage sets the in-memory sample format, see SampleStorage.h. Samples are
+// converted on write and on read, so the interface always deals in T.
+template <typename T, int NumChannels, int GuardSize = 0, typename Storage = T>
+class MultiChannelRingBuffer
+{
+    using Codec = SampleCodec<T, Storage>;
+    static constexpr bool isNative = std::is_same<T, Storage>::value;
+
+    // Reads per decoded window in Reader::nextBlock()
+    static constexpr int READ_CHUNK = 64;
+
+    int bufferSize;
+    int mask;
+    vector<Storage> buffer;
+
+    int writePointer{ 0 };
+
+    void createBuffer(int size) {
+        bufferSize = nearestPowerOfTwo(size);
+        buffer.assign((bufferSize + GuardSize) * NumChannels, Codec::encode(static_cast<T>(0.0f)));
+        mask = bufferSize - 1;
+        writePointer = 0;
+    }
+
+    Storage* frameAt(int position) {
+        return buffer.data() + position * NumChannels;
+    }
+
+    const Storage* frameAt(int position) const {
+        return buffer.data() + position * NumChannels;
+    }
+
+    void mirrorGuard() {
+        if constexpr (GuardSize > 0) {
+            std::copy(frameAt(0), frameAt(GuardSize), frameAt(bufferSize));
+        }
+    }
+
+    // Interpolated read from the oldest tap of one channel
+    template <typename Interpolator>
+    static T interpolate(const Storage* data, int mask, int oldest, float fraction, Interpolator& interpolator) {
+        if constexpr (GuardSize >= INTERPOLATION_GUARD && isNative) {
+            return interpolator.template process<NumChannels>(data + oldest * NumChannels, fraction);
+        }
+        else {
+            T taps[INTERPOLATION_TAPS];
+            for (int i = 0; i < INTERPOLATION_TAPS; ++i) {
+                auto position = GuardSize >= INTERPOLATION_GUARD ? oldest + i : (oldest + i) & mask;
+                taps[i] = Codec::decode(data[position * NumChannels]);
+            }
+            return interpolator.process(taps, fraction);
+        }
+    }
+
+public:
+    using Frame = array<T, NumChannels>;
+
+    // Per-channel read cursor, see RingBuffer::Reader
+    class Reader
+    {
+        const Storage* data;
+        int mask;
+        int position;
+        T fraction;
+
+    public:
+        Reader(const Storage* d, int m, int p, T f) : data(d), mask(m), position(p), fraction(f) {}
+
+        T nextInt() {
+            T out = Codec::decode(data[position * NumChannels]);
+            position = (position + 1) & mask;
+            return out;
+        }
+
+        T next() {
+            T a = Codec::decode(data[position * NumChannels]);
+            T b = Codec::decode(data[((position - 1) & mask) * NumChannels]);
+            position = (position + 1) & mask;
+            return lerp(a, b, fraction);
+        }
+
+        template <typename Interpolator>
+        T next(Interpolator& interpolator) {
+            auto oldest = (position - 2) & mask;
+            position = (position + 1) & mask;
+            return interpolate(data, mask, oldest, fraction, interpolator);
+        }
+
+        // n consecutive interpolated reads into dest. Stored formats decode
+        // the taps of up to READ_CHUNK reads once, with decodeBlock(), and
+        // interpolate from the decoded samples.
+        template <typename Interpolator>
+        void nextBlock(T* dest, int n, Interpolator& interpolator) {
+            if constexpr (isNative) {
+                for (int s = 0; s < n; ++s) {
+                    dest[s] = next(interpolator);
+                }
+            }
+            else {
+                Storage raw[READ_CHUNK + INTERPOLATION_TAPS - 1];
+                T taps[READ_CHUNK + INTERPOLATION_TAPS - 1];
+
+                for (int start = 0; start < n; start += READ_CHUNK) {
+                    auto reads = std::min(READ_CHUNK, n - start);
+                    auto oldest = position - 2;
+                    for (int i = 0; i < reads + INTERPOLATION_TAPS - 1; ++i) {
+                        raw[i] = data[((oldest + i) & mask) * NumChannels];
+                    }
+                    decodeBlock(raw, taps, reads + INTERPOLATION_TAPS - 1);
+
+                    for (int s = 0; s < reads; ++s) {
+                        dest[start + s] = interpolator.process(taps + s, fraction);
+                    }
+                    position = (position + reads) & mask;
+                }
+            }
+        }
+    };
+
+    MultiChannelRingBuffer(int size) {
+        createBuffer(size);
+    }
+
+    MultiChannelRingBuffer() {
+        createBuffer(DEFAULT_BUFFER_SIZE);
+    }
+
+    // See RingBuffer::fits() and RingBuffer::resize()
+    bool fits(int size) const {
+        return static_cast<int>(nearestPowerOfTwo(size)) <= bufferSize;
+    }
+
+    void resize(int size) {
+        if (fits(size)) clear();
+        else createBuffer(size);
+    }
+
+    void clear() {
+        std::fill(buffer.begin(), buffer.end(), Codec::encode(static_cast<T>(0.0f)));
+        writePointer = 0;
+    }
+
+    void write(const Frame& frame) {
+        auto dest = frameAt(writePointer);
+        for (int ch = 0; ch < NumChannels; ++ch) {
+            dest[ch] = Codec::encode(frame[ch]);
+        }
+        if constexpr (GuardSize > 0) {
+            if (writePointer < GuardSize) std::copy(dest, dest + NumChannels, frameAt(bufferSize + writePointer));
+        }
+        writePointer++;
+        writePointer &= mask;
+    }
+
+    T readInt(int channel, int delaySize) const {
+        return Codec::decode(frameAt((writePointer - 1 - delaySize) & mask)[channel]);
+    }
+
+    T read(int channel, float delaySize) const {
+        T a = readInt(channel, delaySize);
+        T b = readInt(channel, delaySize + 1);
+        T f = delaySize - static_cast<int>(delaySize);
+        return lerp(a, b, f);
+    }
+
+    template <typename Interpolator>
+    T read(int channel, float delaySize, Interpolator& interpolator) const {
+        auto integer = static_cast<int>(delaySize);
+        auto oldest = (writePointer - 3 - integer) & mask;
+        return interpolate(buffer.data() + channel, mask, oldest, delaySize - integer, interpolator);
+    }
+
+    // Taps for several interpolated reads at once, as read() takes them:
+    // taps[t * Lanes + lane] is tap t of channels[lane] at integer delay delays[lane]
+    template <int Lanes>
+    void gatherTaps(const int* channels, const int* delays, T* taps) const {
+        for (int lane = 0; lane < Lanes; ++lane) {
+            auto oldest = (writePointer - 3 - delays[lane]) & mask;
+            for (int t = 0; t < INTERPOLATION_TAPS; ++t) {
+                auto position = GuardSize >= INTERPOLATION_GUARD ? oldest + t : (oldest + t) & mask;
+                taps[t * Lanes + lane] = Codec::decode(buffer[position * NumChannels + channels[lane]]);
+            }
+        }
+    }
+
+    // All channels at the same delay
+    Frame readFrame(int delaySize) const {
+        Frame out;
+        decodeBlock(frameAt((writePointer - 1 - delaySize) & mask), out.data(), NumChannels);
+        return out;
+    }
+
+    // Interleave and write one block of planar channel data. Frames are
+    // interleaved into a small scratch block first so the format conversion
+    // runs over contiguous samples.
+    void writeBlock(const T* const* channels, int n) {
+        constexpr int scratchFrames = 64;
+        T scratch[scratchFrames * NumChannels];
+
+        for (int start = 0; start < n; start += scratchFrames) {
+            auto frames = std::min(scratchFrames, n - start);
+            for (int s = 0; s < frames; ++s) {
+                for (int ch = 0; ch < NumChannels; ++ch) {
+                    scratch[s * NumChannels + ch] = channels[ch][start + s];
+                }
+            }
+            auto firstSize = std::min(frames, bufferSize - writePointer);
+            encodeBlock(scratch, frameAt(writePointer), firstSize * NumChannels);
+            encodeBlock(scratch + firstSize * NumChannels, frameAt(0), (frames - firstSize) * NumChannels);
+            writePointer = (writePointer + frames) & mask;
+        }
+        mirrorGuard();
+    }
+
+    // Write n frames that are already interleaved
+    void writeFrames(const T* frames, int n) {
+        auto firstSize = std::min(n, bufferSize - writePointer);
+        encodeBlock(frames, frameAt(writePointer), firstSize * NumChannels);
+        encodeBlock(frames + firstSize * NumChannels, frameAt(0), (n - firstSize) * NumChannels);
+        writePointer = (writePointer + n) & mask;
+        mirrorGuard();
+    }
+
+    // Decode n interleaved frames starting at the frame readFrame(delaySize)
+    // returns, oldest first. Only valid while n <= delaySize + 1.
+    void readFrames(int delaySize, T* dest, int n) const {
+        auto start = (writePointer - 1 - delaySize) & mask;
+        auto firstSize = std::min(n, bufferSize - start);
+        decodeBlock(frameAt(start), dest, firstSize * NumChannels);
+        decodeBlock(frameAt(0), dest + firstSize * NumChannels, (n - firstSize) * NumChannels);
+    }
+
+    // Raw storage for the frames readFrames() would decode. Span indices count
+    // samples, so a frame spans NumChannels consecutive entries.
+    RingSpan<const Storage> getReadSpan(int delaySize, int n) const {
+        auto start = (writePointer - 1 - delaySize) & mask;
+        auto firstSize = std::min(n, bufferSize - start);
+        return { frameAt(start), firstSize * NumChannels, buffer.data(), (n - firstSize) * NumChannels };
+    }
+
+    Reader getReader(int channel, float delaySize) const {
+        auto integer = static_cast<int>(delaySize);
+        T fraction = delaySize - integer;
+        return Reader(buffer.data() + channel, mask, (writePointer - 1 - integer) & mask, fraction);
+    }
+
+    int getSize() {
+        return bufferSize * NumChannels * sizeof(Storage);
+    }
+
+    ~MultiChannelRingBuffer() {}
+};
@@ -11,12 +11,19 @@
 #pragma once
 
 #include <cmath>
+#include <array>
+#include "Utils.h"
 
 #define M_PI 3.14159265358979323846
 #define DEFAULT_SR  44100.0f
 
+// Cutoff changes smaller than this (in Hz) keep the current coefficients
+#define FREQUENCY_EPSILON   0.01f
+
 // https://www.earlevel.com/main/2012/12/15/a-one-pole-filter/
+// T is the sample type; cutoff and sample rate are always float.
 
+template <typename T>
 class OnePoleFilter
 {
 public:
@@ -26,11 +33,16 @@ public:
 
     void setSampleRate(float sr) {
         sampleRate = sr;
+        frequency = -1.0f;
     }
 
+    // Cheap to call every block: coefficients are only recomputed when the
+    // cutoff has moved by more than FREQUENCY_EPSILON
     void setFrequency(float freq) {
-        b1 = exp(-2.0f * M_PI * (freq / sampleRate));
-        a0 = 1.0f - b1;
+        if (std::abs(freq - frequency) < FREQUENCY_EPSILON) return;
+        frequency = freq;
+        b1 = static_cast<T>(fastExp(static_cast<float>(-2.0 * M_PI) * (freq / sampleRate)));
+        a0 = static_cast<T>(1) - b1;
     }
 
     void prepare(float sr, float f) {
@@ -39,17 +51,46 @@ public:
     }
 
 
-    float process(float in) {
+    T process(T in) {
         z1 = in * a0 + z1 * b1;
         return z1;
     }
 
-    float updateAndProcess(float freq, float in) {
+    T updateAndProcess(float freq, T in) {
         setFrequency(freq);
         return process(in);
     }
 
 protected:
-    float a0{ 1.0 }, b1{ 0.0 }, z1{0.0};
+    T a0{ 1.0 }, b1{ 0.0 }, z1{0.0};
     float sampleRate{DEFAULT_SR};
+    float frequency{ -1.0f };
+};
+
+// One filter per channel with a shared cutoff. The channel states sit side by
+// side as lanes, so filtering one interleaved frame is a fixed-width loop the
+// compiler turns into SIMD.
+template <typename T, int MaxLanes>
+class OnePoleFilterBank : public OnePoleFilter<T>
+{
+    alignas(32) std::array<T, MaxLanes> state{};
+
+public:
+    void prepare(float sr, float f) {
+        OnePoleFilter<T>::prepare(sr, f);
+        reset();
+    }
+
+    void reset() {
+        state.fill(static_cast<T>(0));
+    }
+
+    template <int Lanes>
+    void process(const T* in, T* out) {
+        static_assert(Lanes <= MaxLanes, "Too many lanes");
+        for (int lane = 0; lane < Lanes; ++lane) {
+            state[lane] = in[lane] * this->a0 + state[lane] * this->b1;
+            out[lane] = state[lane];
+        }
+    }
 };
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+// One complete set of parameter values, and the bits of the ones that changed
+// since the previous set the reader took
+template <int Size>
+struct ParameterFrame {
+    std::array<float, Size> values{};
+    uint64_t dirty{ 0 };
+
+    bool changed(int index) const {
+        return (dirty >> index) & 1;
+    }
+};
+
+// Lock-free triple buffer carrying parameter frames from one writer thread to
+// the audio thread. The writer fills its back frame and swaps it with the
+// middle one. The reader swaps its front frame with the middle one when that
+// holds a frame it has not seen. Neither side waits for the other, and the
+// reader always gets the newest complete frame.
+//
+// Frames the reader skips are not lost: their dirty bits carry into the next
+// frame, so the reader still applies every field that moved.
+template <int Size>
+class ParameterSnapshot
+{
+    static_assert(Size <= 64, "One dirty bit per parameter");
+
+    // Set on the middle index while it holds a frame the reader has not taken
+    static constexpr int FRESH = 4;
+    static constexpr int INDEX = 3;
+
+    alignas(64) std::array<ParameterFrame<Size>, 3> frames;
+    alignas(64) std::atomic<int> middle{ 1 };
+
+    // Writer side. NaN compares unequal to everything, so the first frame
+    // marks every parameter dirty.
+    alignas(64) int back{ 0 };
+    std::array<float, Size> latest;
+    uint64_t carried{ 0 };
+
+    // Reader side
+    alignas(64) int front{ 2 };
+
+public:
+    ParameterSnapshot() {
+        latest.fill(std::numeric_limits<float>::quiet_NaN());
+    }
+
+    // Writer: publishes values if any of them changed. Returns false if not.
+    bool publish(const float* values) {
+        uint64_t changes = 0;
+        for (int i = 0; i < Size; ++i) {
+            if (values[i] != latest[i]) {
+                changes |= uint64_t{ 1 } << i;
+                latest[i] = values[i];
+            }
+        }
+        if (changes == 0) return false;
+
+        auto dirty = changes | carried;
+        frames[back].values = latest;
+        frames[back].dirty = dirty;
+
+        auto previous = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+        back = previous & INDEX;
+
+        // A frame the reader never took still has to reach it through this one
+        carried = (previous & FRESH) ? dirty : changes;
+        return true;
+    }
+
+    // Reader: takes the newest frame if there is one the reader has not seen
+    bool consume() {
+        if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    // Reader: the frame taken by the last consume()
+    const ParameterFrame<Size>& current() const {
+        return frames[front];
+    }
+};
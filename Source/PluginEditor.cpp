@@ -37,6 +37,7 @@ DelayAudioProcessorEditor::DelayAudioProcessorEditor (DelayAudioProcessor& p)
     addAndMakeVisible(bpmScreen);
     addAndMakeVisible(tmg);
     addAndMakeVisible(presetMenu);
+    addChildComponent(timingOverlay);
 
     setSize (BASE_W * MULT, BASE_H * MULT);
 }
@@ -74,4 +75,48 @@ void DelayAudioProcessorEditor::resized()
     timeDivRightBox .setBounds(timeDivRightBox.left, timeDivRightBox.top, timeDivRightBox.width, timeDivRightBox.height);
     bpmScreen       .setBounds(bpmScreen.left, bpmScreen.top, bpmScreen.width, bpmScreen.height);
     presetMenu      .setBounds(presetMenu.getBounds());
+    timingOverlay   .setBounds(574 * MULT, 306 * MULT, 238 * MULT, 82 * MULT);
+}
+
+void DelayAudioProcessorEditor::mouseDown(const juce::MouseEvent& e)
+{
+    if (e.mods.isPopupMenu()) showOptionsMenu();
+}
+
+void DelayAudioProcessorEditor::showOptionsMenu()
+{
+    auto& timing = audioProcessor.getBlockTiming();
+
+    // Saved with the plug-in state. Switching clears the delay lines.
+    juce::PopupMenu storageMenu;
+    auto storage = audioProcessor.getDelayStorage();
+    auto addStorage = [&](const juce::String& name, DelayStorage format) {
+        storageMenu.addItem(name, true, storage == format, [this, format] {
+            audioProcessor.setDelayStorage(format);
+        });
+    };
+    addStorage("32-bit float", DelayStorage::FLOAT32);
+    addStorage("16-bit fixed point (half the memory)", DelayStorage::FIXED16);
+    addStorage("16-bit float (half the memory)", DelayStorage::HALF16);
+
+    juce::PopupMenu menu;
+    menu.addSubMenu("Delay memory", storageMenu);
+    menu.addSeparator();
+    menu.addItem("Show CPU timing", true, timingOverlay.isVisible(), [this] {
+        timingOverlay.setVisible(!timingOverlay.isVisible());
+    });
+    menu.addItem("Save CPU timing as CSV...", [this, &timing] {
+        timingChooser = std::make_unique<juce::FileChooser>(
+            "Save CPU timing",
+            juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("SpaceChiliTiming.csv"),
+            "*.csv"
+        );
+        timingChooser->launchAsync(juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::warnAboutOverwriting,
+            [&timing](const juce::FileChooser& chooser) {
+                auto file = chooser.getResult();
+                if (file != juce::File()) file.replaceWithText(timing.toCSV());
+            });
+    });
+    menu.addItem("Reset CPU timing", [&timing] { timing.reset(); });
+    menu.showMenuAsync(juce::PopupMenu::Options());
 }
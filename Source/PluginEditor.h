@@ -46,8 +46,10 @@ public:
     //==============================================================================
     void paint (juce::Graphics&) override;
     void resized() override;
+    void mouseDown(const juce::MouseEvent& e) override;
 
 private:
+    void showOptionsMenu();
     DelayAudioProcessor& audioProcessor;
 
     juce::Image bgImage;
@@ -122,5 +124,10 @@ private:
     TimeManagementGroup tmg{ tmgArea, audioProcessor.apvts, &leftLengthKnob, &rightLengthKnob, &linkBtn, &timeDivLeftBox, &timeDivRightBox, &tempoSyncBtn};
 
     PresetMenu presetMenu{ juce::Rectangle<float>(574 * MULT, 225 * MULT, 238 * MULT, 70 * MULT), audioProcessor.getPresetManager()};
+
+    // Right-click on the background: delay memory format, CPU timing overlay
+    // and CSV export
+    TimingOverlay timingOverlay{ audioProcessor.getBlockTiming() };
+    std::unique_ptr<juce::FileChooser> timingChooser;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DelayAudioProcessorEditor)
 };
@@ -18,13 +18,6 @@ inline static void castParameter(juce::AudioProcessorValueTreeState& apvts,
     // parameter does not exist or wrong type
 }
 
-float BPM2Ms(int choice, float tempo=120.0f, int timeMode=1) {
-    auto mult = 4.0f / static_cast<float>(1 << (choice));
-    if (timeMode == TimeMode::TRIPLETS) mult *= (2.0f / 3.0f);   
-    if (timeMode == TimeMode::DOTTED) mult *= 1.5f;
-    return static_cast<float>((60000.0f / tempo) * mult);
-}
-
 //==============================================================================
 DelayAudioProcessor::DelayAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -36,9 +29,7 @@ DelayAudioProcessor::DelayAudioProcessor()
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        ),
-    apvts( *this, nullptr, "Parameters", createParameterLayout() ),
-    delay(),
-    chorus()
+    apvts( *this, nullptr, "Parameters", createParameterLayout() )
 #endif
 {
     if (!apvts.state.isValid()) {
@@ -46,30 +37,15 @@ DelayAudioProcessor::DelayAudioProcessor()
         jassertfalse;
     }
     apvts.state.setProperty("presetName", "", nullptr);
+
+#define CAST_PARAMETER(id, ...) castParameter(apvts, ParameterID::id, id##Param);
+    PLUGIN_PARAMETERS(CAST_PARAMETER, CAST_PARAMETER, CAST_PARAMETER, CAST_PARAMETER)
+#undef CAST_PARAMETER
+
+    // The listener publishes from the parameter pointers, so it goes after them
+    publishParameters();
     apvts.state.addListener(this);
     presetManager = std::make_unique<PresetManager>(apvts);
-
-    castParameter(apvts, ParameterID::leftDelaySize, leftDelaySizeParam);
-    castParameter(apvts, ParameterID::rightDelaySize, rightDelaySizeParam);
-    castParameter(apvts, ParameterID::feedback, feedbackParam);
-    castParameter(apvts, ParameterID::dryWet, dryWetParam);
-    castParameter(apvts, ParameterID::delaySync, delaySyncParam);
-    castParameter(apvts, ParameterID::syncToBPM, syncToBPMParam);
-    castParameter(apvts, ParameterID::internalOrHost, internalOrHostParam);
-    castParameter(apvts, ParameterID::internalBPM, internalBPMParam);
-    castParameter(apvts, ParameterID::syncedTimeSubdivisionL, syncedTimeSubdivParamL);
-    castParameter(apvts, ParameterID::syncedTimeSubdivisionR, syncedTimeSubdivParamR);
-    castParameter(apvts, ParameterID::timeModeL, timeModeParamL);
-    castParameter(apvts, ParameterID::timeModeR, timeModeParamR);
-    castParameter(apvts, ParameterID::pingPong, pingPongParam);
-    castParameter(apvts, ParameterID::leftRightRatio, leftRightRatioParam);
-    castParameter(apvts, ParameterID::lowPassFreq, lowPassFreqParam);
-    castParameter(apvts, ParameterID::highPassFreq, highPassFreqParam);
-    castParameter(apvts, ParameterID::duckingAmount, duckingAmountParam);
-    castParameter(apvts, ParameterID::delayOn, delayOnParam);
-    castParameter(apvts, ParameterID::chorusOn, chorusOnParam);
-    castParameter(apvts, ParameterID::chorusDepth, chorusDepthParam);
-    castParameter(apvts, ParameterID::chorusRate, chorusRateParam);
 }
 
 DelayAudioProcessor::~DelayAudioProcessor()
@@ -112,7 +88,7 @@ bool DelayAudioProcessor::isMidiEffect() const
 
 double DelayAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailLengthSeconds.load();
 }
 
 int DelayAudioProcessor::getNumPrograms()
@@ -140,33 +116,127 @@ void DelayAudioProcessor::changeProgramName (int index, const juce::String& newN
 }
 
 //==============================================================================
-void DelayAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+// Bus layout, block size and defaults for every parameter
+void DelayAudioProcessor::configureParameters(DSPParameters<float>& delay, DSPParameters<float>& chorus,
+    double sampleRate, int samplesPerBlock)
 {
     int nChannels = getTotalNumInputChannels();
+    auto layout = static_cast<float>(layoutFor(nChannels, getTotalNumOutputChannels()));
     
-    delayParameters.set("sampleRate", sampleRate);
-    delayParameters.set("blockSize", samplesPerBlock);
-    delayParameters.set("nChannels", nChannels);
-    delayParameters.set("delayLength", DEFAULT_DELAY_LEN);
-    delayParameters.set("feedback", DEFAULT_FEEDBACK_GAIN * 0.01f);
-    delayParameters.set("mix", DEFAULT_DRY_WET * 0.01f);
-    delayParameters.set("pingPong", static_cast<float>(DEFAULT_IS_PINGPONG));
-    delayParameters.set("lowPassFreq", DEFAULT_LOW_PASS);
-    delayParameters.set("highPassFreq", DEFAULT_HIGH_PASS);
-    delayParameters.set("ducking", DEFAULT_DUCKING);
-    delayParameters.set("isOn", static_cast<float>(DEFAULT_DELAY_ON));
+    delay.set(Param::sampleRate, sampleRate);
+    delay.set(Param::blockSize, samplesPerBlock);
+    delay.set(Param::nChannels, nChannels);
+    delay.set(Param::layout, layout);
+    delay.set(Param::nOutputChannels, getTotalNumOutputChannels());
+    delay.set(Param::delayLength, DEFAULT_DELAY_LEN);
+    delay.set(Param::feedback, DEFAULT_FEEDBACK_GAIN * 0.01f);
+    delay.set(Param::mix, DEFAULT_DRY_WET * 0.01f);
+    delay.set(Param::pingPong, static_cast<float>(DEFAULT_IS_PINGPONG));
+    delay.set(Param::pingPongRotation, DEFAULT_PINGPONG_ROTATION);
+    delay.set(Param::lowPassFreq, DEFAULT_LOW_PASS);
+    delay.set(Param::highPassFreq, DEFAULT_HIGH_PASS);
+    delay.set(Param::filterSlope, DEFAULT_FILTER_SLOPE);
+    delay.set(Param::filterInLoop, static_cast<float>(DEFAULT_FILTER_IN_LOOP));
+    delay.set(Param::ducking, DEFAULT_DUCKING);
+    delay.set(Param::isOn, static_cast<float>(DEFAULT_DELAY_ON));
+    delay.set(Param::storage, static_cast<float>(getDelayStorage()));
+
+    chorus.set(Param::sampleRate, sampleRate);
+    chorus.set(Param::blockSize, samplesPerBlock);
+    chorus.set(Param::nChannels, nChannels);
+    chorus.set(Param::layout, layout);
+    chorus.set(Param::nOutputChannels, getTotalNumOutputChannels());
+    chorus.set(Param::chorusRate, DEFAULT_CHORUS_RATE);
+    chorus.set(Param::chorusDepth, DEFAULT_CHORUS_DEPTH * 0.01f);
+    chorus.set(Param::isOn, DEFAULT_CHORUS_ON);
+    chorus.set(Param::voices, 2 << DEFAULT_CHORUS_VOICES);
+}
 
-    delay.prepare(delayParameters);
+void DelayAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+    const juce::ScopedLock lock(prepareLock);
+    configureParameters(delayParameters, chorusParameters, sampleRate, samplesPerBlock);
 
-    chorusParameters.set("sampleRate", sampleRate);
-    chorusParameters.set("blockSize", samplesPerBlock);
-    chorusParameters.set("nChannels", nChannels);
-    chorusParameters.set("chorusRate", DEFAULT_CHORUS_RATE);
-    chorusParameters.set("chorusDepth", DEFAULT_CHORUS_DEPTH * 0.01f);
-    chorusParameters.set("isOn", DEFAULT_CHORUS_ON);
+    // The engine starts from the current delay times, not the defaults
+    std::array<float, HOST_PARAMETER_COUNT> values;
+    readHostParameters(values.data());
+    mapHostParameters(values.data(), ALL_PARAMETERS, currentHostBPM.load(), delayParameters, chorusParameters);
 
+    if (getProcessingPrecision() == doublePrecision) {
+        prepareEngine(doubleEngine);
+        engine.publish(nullptr);
+    }
+    else {
+        prepareEngine(engine);
+        doubleEngine.publish(nullptr);
+    }
+    applyAllParameters.store(true);
+}
+
+template <typename SampleType>
+void DelayAudioProcessor::prepareEngine(EngineSlot<DelayEngine<SampleType>>& slot)
+{
+    // Same or smaller capacity: re-prepare in place without allocating.
+    // Otherwise build and prepare a new engine here and swap it in.
+    auto current = slot.get();
+    if (current != nullptr && current->fits(delayParameters, chorusParameters)) {
+        current->prepare(delayParameters, chorusParameters);
+    }
+    else {
+        auto fresh = std::make_unique<DelayEngine<SampleType>>();
+        fresh->prepare(delayParameters, chorusParameters);
+        slot.publish(std::move(fresh));
+    }
+}
 
-    chorus.prepare(chorusParameters);
+DelayStorage DelayAudioProcessor::getDelayStorage() const
+{
+    int format = apvts.state.getProperty(delayStorageProperty, DelayStorage::FLOAT32);
+    return format == DelayStorage::FIXED16 || format == DelayStorage::HALF16 ? static_cast<DelayStorage>(format) : DelayStorage::FLOAT32;
+}
+
+void DelayAudioProcessor::setDelayStorage(DelayStorage format)
+{
+    apvts.state.setProperty(delayStorageProperty, static_cast<int>(format), nullptr);
+}
+
+// The delay line format is fixed when an engine is prepared, so a new one
+// needs a new engine. It is built here with the current parameter values and
+// swapped in, and the delay lines start out empty.
+void DelayAudioProcessor::applyDelayStorage()
+{
+    const juce::ScopedLock lock(prepareLock);
+    auto format = static_cast<float>(getDelayStorage());
+    if (delayParameters[Param::storage] == format) return;
+    delayParameters.set(Param::storage, format);
+
+    // Nothing to rebuild before the first prepareToPlay()
+    if (engine.get() == nullptr && doubleEngine.get() == nullptr) return;
+
+    std::array<float, HOST_PARAMETER_COUNT> values;
+    readHostParameters(values.data());
+
+    DSPParameters<float> delay;
+    DSPParameters<float> chorus;
+    configureParameters(delay, chorus, getSampleRate(), getBlockSize());
+    mapHostParameters(values.data(), ALL_PARAMETERS, currentHostBPM.load(), delay, chorus);
+
+    if (getProcessingPrecision() == doublePrecision) {
+        rebuildEngine(doubleEngine, delay, chorus);
+    }
+    else {
+        rebuildEngine(engine, delay, chorus);
+    }
+}
+
+template <typename SampleType>
+void DelayAudioProcessor::rebuildEngine(EngineSlot<DelayEngine<SampleType>>& slot,
+    DSPParameters<float>& delay, DSPParameters<float>& chorus)
+{
+    auto fresh = std::make_unique<DelayEngine<SampleType>>();
+    fresh->prepare(delay, chorus);
+    fresh->update(delay, chorus);
+    slot.publish(std::move(fresh));
 }
 
 void DelayAudioProcessor::releaseResources()
@@ -182,17 +252,17 @@ bool DelayAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) co
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Mono, stereo, mono in / stereo out and surround up to MAX_CHANNELS,
+    // see ChannelLayout.h. Some plugin hosts, such as certain GarageBand
+    // versions, will only load plugins that support stereo bus layouts.
+    const auto output = layouts.getMainOutputChannelSet();
+    if (output.isDisabled() || output.size() > MAX_CHANNELS)
         return false;
 
-    // This checks if the input layout matches the output layout
    #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+    const auto input = layouts.getMainInputChannelSet();
+    if (input != output
+     && ! (input == juce::AudioChannelSet::mono() && output == juce::AudioChannelSet::stereo()))
         return false;
    #endif
 
@@ -201,7 +271,25 @@ bool DelayAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) co
 }
 #endif
 
+bool DelayAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
 void DelayAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    ScopedBlockTimer timer(blockTiming, buffer.getNumSamples(), getSampleRate());
+    process(buffer, engine);
+}
+
+void DelayAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    ScopedBlockTimer timer(blockTiming, buffer.getNumSamples(), getSampleRate());
+    process(buffer, doubleEngine);
+}
+
+template <typename SampleType>
+void DelayAudioProcessor::process(juce::AudioBuffer<SampleType>& buffer, EngineSlot<DelayEngine<SampleType>>& slot)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -210,67 +298,72 @@ void DelayAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    bool expected = true;
-    bool bpmChanged = false;
+    typename EngineSlot<DelayEngine<SampleType>>::ScopedAccess dsp(slot);
+    if (dsp.get() == nullptr) return;
+
+    // Offline, the host may not give the message thread time to publish
+    if (isNonRealtime()) publishParameters();
+
+    uint64_t dirty = 0;
+    if (hostParameters.consume()) dirty = hostParameters.current().dirty;
+    if (applyAllParameters.load() && applyAllParameters.exchange(false)) dirty = ALL_PARAMETERS;
+
+    const auto& values = hostParameters.current().values;
+    bool useHostBPM = values[static_cast<int>(HostParameter::internalOrHost)] == TempoSource::HOST;
     auto hostBPM = getPlayHead()->getPosition()->getBpm();
 
-    if (useHostBPM.load() && hostBPM.hasValue() && *hostBPM != currentHostBPM) {
-        currentHostBPM = *hostBPM;
-        bpmChanged = true;
+    if (useHostBPM && hostBPM.hasValue() && *hostBPM != currentHostBPM.load()) {
+        currentHostBPM.store(static_cast<float>(*hostBPM));
+        dirty |= parameterBit(HostParameter::internalOrHost);
     }
 
-    if (bpmChanged || isNonRealtime() || parametersChanged.compare_exchange_strong(expected, false)) {
-        update(buffer, currentHostBPM);
+    if (dirty != 0) {
+        update(*dsp, values.data(), dirty, currentHostBPM.load());
     }
 
-    delay.processBlock(
-        buffer.getArrayOfWritePointers(),
-        buffer.getNumChannels(),
-        buffer.getNumSamples()
-    );
-    
-    chorus.processBlock(
+    dsp->processBlock(
         buffer.getArrayOfWritePointers(),
         buffer.getNumChannels(),
         buffer.getNumSamples()
     );
 }
 
-void DelayAudioProcessor::update(juce::AudioBuffer<float>& buffer, float hostBPM) {
-    float bpm = useHostBPM.load() ? hostBPM : internalBPMParam->get();
-
-    float leftDelaySize;
-    float rightDelaySize;
-
-    if (syncToBPMParam->get()) {
-        leftDelaySize = BPM2Ms(syncedTimeSubdivParamL->getIndex(), bpm, timeModeParamL->get());
-        rightDelaySize = BPM2Ms(syncedTimeSubdivParamR->getIndex(), bpm, timeModeParamR->get());
-    }
+template <typename SampleType>
+void DelayAudioProcessor::update(DelayEngine<SampleType>& dsp, const float* values, uint64_t dirty, float hostBPM) {
+    mapHostParameters(values, dirty, hostBPM, delayParameters, chorusParameters);
 
-    else {
-        leftDelaySize = leftDelaySizeParam->get();
-        rightDelaySize = rightDelaySizeParam->get();
+    if (dirty & (DELAY_TIME_PARAMETERS | parameterBit(HostParameter::feedback))) {
+        tailLengthSeconds.store(TailTracker::tailSeconds(
+            delayParameters[Param::feedback],
+            std::max(delayParameters[Param::leftDelayLength], delayParameters[Param::rightDelayLength]),
+            Chorus<SampleType>::maxDelayLength
+        ));
     }
 
-    rightDelaySize *= leftRightRatioParam->get();
-
-    delayParameters.set("leftDelayLength",  leftDelaySize);
-    delayParameters.set("rightDelayLength", rightDelaySize);
-    delayParameters.set("feedback", feedbackParam->get() * 0.01f);
-    delayParameters.set("mix", dryWetParam->get() * 0.01f);
-    delayParameters.set("pingPong", static_cast<float>(pingPongParam->get()));
-    delayParameters.set("lowPassFreq", lowPassFreqParam->get());
-    delayParameters.set("highPassFreq", highPassFreqParam->get());
-    delayParameters.set("ducking", duckingAmountParam->get() * 0.01f);
-    delayParameters.set("isOn", static_cast<float>(delayOnParam->get()));
+    dsp.update(delayParameters, chorusParameters, (dirty & DELAY_PARAMETERS) != 0, (dirty & CHORUS_PARAMETERS) != 0);
+}
 
-    delay.update(delayParameters);
+void DelayAudioProcessor::readHostParameters(float* values)
+{
+#define FLOAT_VALUE(id, ...)  values[static_cast<int>(HostParameter::id)] = id##Param->get();
+#define BOOL_VALUE(id, ...)   values[static_cast<int>(HostParameter::id)] = id##Param->get() ? 1.0f : 0.0f;
+#define CHOICE_VALUE(id, ...) values[static_cast<int>(HostParameter::id)] = static_cast<float>(id##Param->getIndex());
+#define INT_VALUE(id, ...)    values[static_cast<int>(HostParameter::id)] = static_cast<float>(id##Param->get());
+    PLUGIN_PARAMETERS(FLOAT_VALUE, BOOL_VALUE, CHOICE_VALUE, INT_VALUE)
+#undef FLOAT_VALUE
+#undef BOOL_VALUE
+#undef CHOICE_VALUE
+#undef INT_VALUE
+}
 
-    chorusParameters.set("chorusDepth", chorusDepthParam->get() * 0.01f);
-    chorusParameters.set("chorusRate", chorusRateParam->get());
-    chorusParameters.set("isOn", chorusOnParam->get());
+void DelayAudioProcessor::publishParameters()
+{
+    std::array<float, HOST_PARAMETER_COUNT> values;
+    readHostParameters(values.data());
 
-    chorus.update(chorusParameters);
+    // Message thread and offline renders can both publish; one at a time
+    const juce::SpinLock::ScopedLockType lock(publishLock);
+    hostParameters.publish(values.data());
 }
 
 //==============================================================================
@@ -298,7 +391,7 @@ void DelayAudioProcessor::setStateInformation (const void* data, int sizeInBytes
     std::unique_ptr<juce::XmlElement> xml(getXmlFromBinary(data, sizeInBytes));
     if (xml.get() != nullptr && xml->hasTagName(apvts.state.getType())) {
         apvts.replaceState(juce::ValueTree::fromXml(*xml));
-        parametersChanged.store(true);
+        publishParameters();
     }
 }
 
@@ -307,149 +400,21 @@ juce::AudioProcessorValueTreeState::ParameterLayout DelayAudioProcessor::createP
     juce::AudioProcessorValueTreeState::ParameterLayout layout;
 
 
-    layout.add(std::make_unique <juce::AudioParameterFloat>(
-        ParameterID::leftDelaySize,
-        "Left (ms)",
-        juce::NormalisableRange<float>{ 1.0f, 2500.0f, 0.01f, 0.8f },
-        DEFAULT_DELAY_LEN
-        ));
-
-    layout.add(std::make_unique <juce::AudioParameterFloat>(
-        ParameterID::rightDelaySize,
-        "Right (ms)",
-        juce::NormalisableRange<float>{ 1.0f, 2500.0f, 0.01f, 0.8f },
-        DEFAULT_DELAY_LEN
-        ));
-
-    layout.add(std::make_unique <juce::AudioParameterFloat>(
-        ParameterID::feedback,
-        "Feedback",
-        juce::NormalisableRange<float>{0.0f, 100.0f, 0.1f},
-        DEFAULT_FEEDBACK_GAIN
-        ));
-    
-    layout.add(std::make_unique <juce::AudioParameterFloat>(
-        ParameterID::dryWet,
-        "Dry/Wet",
-        juce::NormalisableRange<float>{0.0f, 100.0f, 0.1f},
-        DEFAULT_DRY_WET
-        ));
-    
-    layout.add(std::make_unique <juce::AudioParameterBool>(
-        ParameterID::delaySync,
-        "Link",
-        DEFAULT_LINK
-        ));    
-    
-    layout.add(std::make_unique <juce::AudioParameterBool>(
-        ParameterID::syncToBPM,
-        "Sync to BPM",
-        DEFAULT_SYNC
-        ));    
-
-    layout.add(std::make_unique <juce::AudioParameterChoice>(
-        ParameterID::internalOrHost,
-        "Clock source",
-        juce::StringArray{ "Internal", "Host"},
-        DEFAULT_CLOCK_SRC
-    ));
-
-    layout.add(std::make_unique <juce::AudioParameterFloat>(
-        ParameterID::internalBPM,
-        "Tempo",
-        juce::NormalisableRange<float>{0.0f, 999.0f, 1.0f},
-        DEFAULT_BPM
-    ));
-
-    
-    layout.add(std::make_unique <juce::AudioParameterChoice>(
-        ParameterID::syncedTimeSubdivisionL,
-        "Time",
-        juce::StringArray{ "1/1", "1/2", "1/4", "1/8", "1/16", "1/32", "1/64"},
-        DEFAULT_SUBDIVISION
-        ));
-    
-    layout.add(std::make_unique <juce::AudioParameterChoice>(
-        ParameterID::syncedTimeSubdivisionR,
-        "Time",
-        juce::StringArray{ "1/1", "1/2", "1/4", "1/8", "1/16", "1/32", "1/64"},
-        DEFAULT_SUBDIVISION
-        ));
+#define FLOAT_PARAMETER(id, name, range, value) \
+    layout.add(std::make_unique<juce::AudioParameterFloat>(ParameterID::id, name, range, value));
+#define BOOL_PARAMETER(id, name, value) \
+    layout.add(std::make_unique<juce::AudioParameterBool>(ParameterID::id, name, value));
+#define CHOICE_PARAMETER(id, name, choices, value) \
+    layout.add(std::make_unique<juce::AudioParameterChoice>(ParameterID::id, name, choices, value));
+#define INT_PARAMETER(id, name, min, max, value) \
+    layout.add(std::make_unique<juce::AudioParameterInt>(ParameterID::id, name, min, max, value));
 
-    layout.add(std::make_unique <juce::AudioParameterInt>(
-        ParameterID::timeModeL,
-        "Time mode left",
-        0, 2,
-        DEFAULT_TIME_MODE
-    ));
-
-    layout.add(std::make_unique <juce::AudioParameterInt>(
-        ParameterID::timeModeR,
-        "Time mode left",
-        0, 2,
-        DEFAULT_TIME_MODE
-    ));
-
-    layout.add(std::make_unique <juce::AudioParameterBool>(
-        ParameterID::pingPong,
-        "Ping Pong",
-        DEFAULT_IS_PINGPONG
-        ));
+    PLUGIN_PARAMETERS(FLOAT_PARAMETER, BOOL_PARAMETER, CHOICE_PARAMETER, INT_PARAMETER)
 
-    layout.add(std::make_unique <juce::AudioParameterFloat>(
-        ParameterID::leftRightRatio,
-        "Ratio",
-        juce::NormalisableRange<float>{0.75f, 1.25f, 0.01f},
-        DEFAULT_LR_RATIO
-    ));
-    
-    layout.add(std::make_unique <juce::AudioParameterFloat>(
-        ParameterID::lowPassFreq,
-        "Lo",
-        juce::NormalisableRange<float>{20.0f, 20000.0f, 0.1f, 0.3f, false},
-        DEFAULT_LOW_PASS
-    ));
-        
-    layout.add(std::make_unique <juce::AudioParameterFloat>(
-        ParameterID::highPassFreq,
-        "Hi",
-        juce::NormalisableRange<float>{20.0f, 20000.0f, 0.1f, 0.3f, false},
-        DEFAULT_HIGH_PASS
-    ));
-            
-    layout.add(std::make_unique <juce::AudioParameterFloat>(
-        ParameterID::duckingAmount,
-        "Ducking",
-        juce::NormalisableRange<float>{0.0f, 100.0f, 0.1f},
-        DEFAULT_DUCKING
-    ));               
-
-    layout.add(std::make_unique <juce::AudioParameterBool>(
-        ParameterID::delayOn,
-        "Delay On",
-        DEFAULT_DELAY_ON
-
-    ));
-    
-    layout.add(std::make_unique <juce::AudioParameterBool>(
-        ParameterID::chorusOn,
-        "Chorus On",
-        DEFAULT_CHORUS_ON
-    ));
-
-    layout.add(std::make_unique <juce::AudioParameterFloat>(
-        ParameterID::chorusDepth,
-        "Chorus Depth",
-        juce::NormalisableRange<float>{0.0f, 100.0f, 0.1f},
-        DEFAULT_CHORUS_DEPTH
-    ));
-    
-    layout.add(std::make_unique <juce::AudioParameterFloat>(
-        ParameterID::chorusRate,
-        "Chorus Rate",
-        juce::NormalisableRange<float>{0.25f, 0.5f, 0.01f},
-        DEFAULT_CHORUS_RATE
-    ));
+#undef FLOAT_PARAMETER
+#undef BOOL_PARAMETER
+#undef CHOICE_PARAMETER
+#undef INT_PARAMETER
 
     return layout;
 }
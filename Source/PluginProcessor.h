@@ -9,64 +9,21 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "StereoDelay.h"
-#include "Chorus.h"
+#include "BlockTiming.h"
+#include "DelayEngine.h"
 #include "DSPParameters.h"
+#include "HostParameters.h"
+#include "ParameterSnapshot.h"
 #include "PresetManager.h"
 
 
 #define PLUGIN_VERSION 1    
 
-enum TempoSource {INTERNAL, HOST};
-enum TimeMode {STRAIGHT, TRIPLETS, DOTTED};
-
-#define DEFAULT_DELAY_LEN       250.0f
-#define DEFAULT_FEEDBACK_GAIN   35.0f
-#define DEFAULT_MIX             35.0f
-#define DEFAULT_LINK            false
-#define DEFAULT_SYNC            false
-#define DEFAULT_BPM             120.0f
-#define DEFAULT_CLOCK_SRC       TempoSource::HOST
-#define DEFAULT_INTERNAL_BPM    120.0f
-#define DEFAULT_SUBDIVISION     3 // 1/8
-#define DEFAULT_TIME_MODE       TimeMode::STRAIGHT
-#define DEFAULT_IS_PINGPONG     0.0f
-#define DEFAULT_LR_RATIO        1.01f
-#define DEFAULT_LOW_PASS        20000.0f
-#define DEFAULT_HIGH_PASS       20.0f
-#define DEFAULT_DUCKING         0.0f
-#define DEFAULT_DELAY_ON        true
-
-#define DEFAULT_CHORUS_ON       false
-#define DEFAULT_CHORUS_DEPTH    50.0f
-#define DEFAULT_CHORUS_RATE     0.25f
-
 namespace ParameterID
 {
-#define PARAMETER_ID(str) const juce::ParameterID str(#str, PLUGIN_VERSION);
-
-    PARAMETER_ID(leftDelaySize)
-    PARAMETER_ID(rightDelaySize)
-    PARAMETER_ID(feedback)
-    PARAMETER_ID(dryWet)
-    PARAMETER_ID(delaySync)
-    PARAMETER_ID(syncToBPM)
-    PARAMETER_ID(internalOrHost)
-    PARAMETER_ID(internalBPM)
-    PARAMETER_ID(syncedTimeSubdivisionL)
-    PARAMETER_ID(syncedTimeSubdivisionR)
-    PARAMETER_ID(timeModeL)
-    PARAMETER_ID(timeModeR)
-    PARAMETER_ID(pingPong)
-    PARAMETER_ID(leftRightRatio)
-    PARAMETER_ID(lowPassFreq)
-    PARAMETER_ID(highPassFreq)
-    PARAMETER_ID(duckingAmount)
-    PARAMETER_ID(delayOn)
-    PARAMETER_ID(chorusOn)
-    PARAMETER_ID(chorusDepth)
-    PARAMETER_ID(chorusRate)
+#define PARAMETER_ID(str, ...) const juce::ParameterID str(#str, PLUGIN_VERSION);
 
+    PLUGIN_PARAMETERS(PARAMETER_ID, PARAMETER_ID, PARAMETER_ID, PARAMETER_ID)
 
 #undef PARAMETER_ID
 }
@@ -89,7 +46,9 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
    #endif
 
+    bool supportsDoublePrecisionProcessing() const override;
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -117,56 +76,81 @@ public:
     
     PresetManager& getPresetManager() { return *presetManager; }
 
+    // Delay line sample format, stored with the plug-in state. A change
+    // swaps in a new engine right away. See SampleStorage.h for the noise
+    // figures.
+    DelayStorage getDelayStorage() const;
+    void setDelayStorage(DelayStorage format);
+
+    // CPU time of each processBlock() call, for the editor's timing overlay
+    BlockTiming& getBlockTiming() { return blockTiming; }
+
 private:
     //==============================================================================
     
     // Parameters
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
-    juce::AudioParameterFloat*  leftDelaySizeParam;
-    juce::AudioParameterFloat*  rightDelaySizeParam;
-    juce::AudioParameterFloat*  feedbackParam;
-    juce::AudioParameterFloat*  dryWetParam;
-    juce::AudioParameterBool*   delaySyncParam;
-    juce::AudioParameterBool*   syncToBPMParam;
-    juce::AudioParameterChoice* internalOrHostParam;
-    juce::AudioParameterFloat*  internalBPMParam;
-    juce::AudioParameterChoice* syncedTimeSubdivParamL;
-    juce::AudioParameterChoice* syncedTimeSubdivParamR;
-    juce::AudioParameterInt*    timeModeParamL;
-    juce::AudioParameterInt*    timeModeParamR;
-    juce::AudioParameterBool*   pingPongParam;
-    juce::AudioParameterFloat*  leftRightRatioParam;
-    juce::AudioParameterFloat*  lowPassFreqParam;
-    juce::AudioParameterFloat*  highPassFreqParam;
-    juce::AudioParameterFloat*  duckingAmountParam;
-    juce::AudioParameterBool*   delayOnParam;
-    juce::AudioParameterBool*   chorusOnParam;
-    juce::AudioParameterFloat*  chorusDepthParam;
-    juce::AudioParameterFloat*  chorusRateParam;
-
-    std::atomic<bool> parametersChanged{ false };
-    std::atomic<int> useHostBPM{ 1 };
-    float currentHostBPM {DEFAULT_BPM};
-
-    void valueTreePropertyChanged(juce::ValueTree&, const juce::Identifier&) override
+#define FLOAT_PARAMETER(id, ...)  juce::AudioParameterFloat*  id##Param;
+#define BOOL_PARAMETER(id, ...)   juce::AudioParameterBool*   id##Param;
+#define CHOICE_PARAMETER(id, ...) juce::AudioParameterChoice* id##Param;
+#define INT_PARAMETER(id, ...)    juce::AudioParameterInt*    id##Param;
+    PLUGIN_PARAMETERS(FLOAT_PARAMETER, BOOL_PARAMETER, CHOICE_PARAMETER, INT_PARAMETER)
+#undef FLOAT_PARAMETER
+#undef BOOL_PARAMETER
+#undef CHOICE_PARAMETER
+#undef INT_PARAMETER
+
+    // Host parameter values travel to the audio thread as snapshots, which
+    // only the publishing side reads from the parameter objects. The audio
+    // thread applies the fields a snapshot marks dirty, or all of them after
+    // prepareToPlay().
+    ParameterSnapshot<HOST_PARAMETER_COUNT> hostParameters;
+    juce::SpinLock publishLock;
+    std::atomic<bool> applyAllParameters{ true };
+    std::atomic<double> tailLengthSeconds{ 0.0 };
+    std::atomic<float> currentHostBPM{ DEFAULT_BPM };
+
+    // Not for the audio thread, except when rendering offline
+    void readHostParameters(float* values);
+    void publishParameters();
+
+    static inline const juce::Identifier delayStorageProperty{ "delayStorage" };
+
+    void valueTreePropertyChanged(juce::ValueTree&, const juce::Identifier& property) override
     {
-        parametersChanged.store(true);
-        useHostBPM.store(internalOrHostParam->getIndex());
+        publishParameters();
+        if (property == delayStorageProperty) applyDelayStorage();
     }
 
     void valueTreeRedirected(juce::ValueTree&) override {
-        parametersChanged.store(true);
-        useHostBPM.store(internalOrHostParam->getIndex());
+        publishParameters();
+        applyDelayStorage();
     }
 
-    void update(juce::AudioBuffer<float>& buffer, float bpm);
-
-    // DSP
-    StereoDelay delay;
-    Chorus chorus;
+    // Engines are prepared and replaced by one thread at a time
+    juce::CriticalSection prepareLock;
+
+    void configureParameters(DSPParameters<float>& delay, DSPParameters<float>& chorus, double sampleRate, int samplesPerBlock);
+    void applyDelayStorage();
+
+    template <typename SampleType>
+    void prepareEngine(EngineSlot<DelayEngine<SampleType>>& slot);
+    template <typename SampleType>
+    void rebuildEngine(EngineSlot<DelayEngine<SampleType>>& slot, DSPParameters<float>& delay, DSPParameters<float>& chorus);
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer, EngineSlot<DelayEngine<SampleType>>& slot);
+    template <typename SampleType>
+    void update(DelayEngine<SampleType>& dsp, const float* values, uint64_t dirty, float bpm);
+
+    // DSP, one engine per processing precision. Only the one matching the
+    // host's precision is prepared; the other holds no memory.
+    EngineSlot<DelayEngine<float>> engine;
+    EngineSlot<DelayEngine<double>> doubleEngine;
     DSPParameters<float> delayParameters;
     DSPParameters<float> chorusParameters;
 
+    BlockTiming blockTiming;
+
     std::unique_ptr<PresetManager>presetManager;    
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DelayAudioProcessor)
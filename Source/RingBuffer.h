@@ -11,12 +11,42 @@
 #pragma once
 
 #include "Utils.h"
+#include "Interpolation.h"
 #include <vector>
+#include <algorithm>
 using std::vector;
 
 #define DEFAULT_BUFFER_SIZE 1
 
+// Samples a delay line needs to serve reads up to maxDelayMs, including the
+// taps an interpolator reads past the integer delay
+inline int delayLineSize(float sampleRate, float maxDelayMs) {
+    return static_cast<int>(std::ceil(lengthToSamples(sampleRate, maxDelayMs))) + INTERPOLATION_TAPS;
+}
+
+// Up to two contiguous runs of samples covering a range of the ring.
+// The second run is only used when the range wraps past the end of the buffer.
 template <typename T>
+struct RingSpan {
+    T* first{ nullptr };
+    int firstSize{ 0 };
+    T* second{ nullptr };
+    int secondSize{ 0 };
+
+    int size() const {
+        return firstSize + secondSize;
+    }
+
+    T& operator[] (int i) const {
+        return i < firstSize ? first[i] : second[i - firstSize];
+    }
+};
+
+// GuardSize > 0 keeps a copy of the first GuardSize samples after the end of
+// the buffer, updated on every write. Reads of up to GuardSize + 1 consecutive
+// samples can then start anywhere in the buffer without wrapping, so the
+// interpolated reads mask once and load all taps straight from memory.
+template <typename T, int GuardSize = 0>
 class RingBuffer
 {
     int bufferSize;
@@ -28,12 +58,71 @@ class RingBuffer
 
     void createBuffer(int size) {
         bufferSize = nearestPowerOfTwo(size);
-        buffer.resize(bufferSize, static_cast<T>(0.0f));
+        buffer.assign(bufferSize + GuardSize, static_cast<T>(0.0f));
         mask = bufferSize - 1;
+        writePointer = 0;
+    }
+
+    void mirrorGuard() {
+        if constexpr (GuardSize > 0) {
+            std::copy(buffer.begin(), buffer.begin() + GuardSize, buffer.begin() + bufferSize);
+        }
+    }
+
+    template <typename U>
+    RingSpan<U> makeSpan(U* data, int start, int n) const {
+        auto firstSize = std::min(n, bufferSize - start);
+        return { data + start, firstSize, data, n - firstSize };
     }
 
 public:
 
+    // Read cursor that follows the write pointer at a fixed delay.
+    // Call next() once per written sample: the position advances with a single
+    // increment and mask instead of recomputing it from the write pointer.
+    class Reader
+    {
+        const T* data;
+        int mask;
+        int position;
+        T fraction;
+
+    public:
+        Reader(const T* d, int m, int p, T f) : data(d), mask(m), position(p), fraction(f) {}
+
+        // Integer delay
+        T nextInt() {
+            T out = data[position];
+            position = (position + 1) & mask;
+            return out;
+        }
+
+        // Fractional delay, same interpolation as RingBuffer::read()
+        T next() {
+            T a = data[position];
+            T b = data[(position - 1) & mask];
+            position = (position + 1) & mask;
+            return lerp(a, b, fraction);
+        }
+
+        // Fractional delay through an interpolator from Interpolation.h
+        template <typename Interpolator>
+        T next(Interpolator& interpolator) {
+            auto oldest = (position - 2) & mask;
+            position = (position + 1) & mask;
+            if constexpr (GuardSize >= INTERPOLATION_GUARD) {
+                return interpolator.process(data + oldest, fraction);
+            }
+            else {
+                T taps[INTERPOLATION_TAPS];
+                for (int i = 0; i < INTERPOLATION_TAPS; ++i) {
+                    taps[i] = data[(oldest + i) & mask];
+                }
+                return interpolator.process(taps, fraction);
+            }
+        }
+    };
+
     RingBuffer(int size) {
         createBuffer(size);
     }
@@ -42,8 +131,28 @@ public:
         createBuffer(DEFAULT_BUFFER_SIZE);
     }
 
+    // True when resize(size) can reuse the current storage
+    bool fits(int size) const {
+        return static_cast<int>(nearestPowerOfTwo(size)) <= bufferSize;
+    }
+
+    // Make room for size samples and clear. Existing storage is kept when it
+    // is large enough, so re-preparing at the same rate does not allocate.
+    void resize(int size) {
+        if (fits(size)) clear();
+        else createBuffer(size);
+    }
+
+    void clear() {
+        std::fill(buffer.begin(), buffer.end(), static_cast<T>(0.0f));
+        writePointer = 0;
+    }
+
     void write(T value) {
         buffer[writePointer] = value;
+        if constexpr (GuardSize > 0) {
+            if (writePointer < GuardSize) buffer[bufferSize + writePointer] = value;
+        }
         writePointer++;
         writePointer &= mask;
     }
@@ -61,6 +170,56 @@ public:
         return lerp(a, b, f);
     }
 
+    template <typename Interpolator>
+    T read(float delaySize, Interpolator& interpolator) {
+        auto integer = static_cast<int>(delaySize);
+        auto oldest = (writePointer - 3 - integer) & mask;
+        if constexpr (GuardSize >= INTERPOLATION_GUARD) {
+            return interpolator.process(buffer.data() + oldest, delaySize - integer);
+        }
+        else {
+            T taps[INTERPOLATION_TAPS];
+            for (int i = 0; i < INTERPOLATION_TAPS; ++i) {
+                taps[i] = buffer[(oldest + i) & mask];
+            }
+            return interpolator.process(taps, delaySize - integer);
+        }
+    }
+
+    // Write a whole block. Equivalent to calling write() for every sample.
+    void writeBlock(const T* src, int n) {
+        auto span = makeSpan(buffer.data(), writePointer, n);
+        std::copy(src, src + span.firstSize, span.first);
+        std::copy(src + span.firstSize, src + n, span.second);
+        writePointer = (writePointer + n) & mask;
+        mirrorGuard();
+    }
+
+    // Storage for the next n samples to be written, to be filled in place
+    // and committed with advance(n).
+    RingSpan<T> getWriteSpan(int n) {
+        return makeSpan(buffer.data(), writePointer, n);
+    }
+
+    void advance(int n) {
+        writePointer = (writePointer + n) & mask;
+        mirrorGuard();
+    }
+
+    // The n samples that readInt(delaySize) would return over the next n
+    // calls to write(). Only valid while n <= delaySize + 1, i.e. when the
+    // whole range has already been written.
+    RingSpan<const T> getReadSpan(int delaySize, int n) const {
+        auto start = (writePointer - 1 - delaySize) & mask;
+        return makeSpan(static_cast<const T*>(buffer.data()), start, n);
+    }
+
+    Reader getReader(float delaySize) const {
+        auto integer = static_cast<int>(delaySize);
+        T fraction = delaySize - integer;
+        return Reader(buffer.data(), mask, (writePointer - 1 - integer) & mask, fraction);
+    }
+
     int getSize() {
         return bufferSize * 4.0f;
     }
@@ -28,12 +28,12 @@ struct SimpleDelay {
 		dryWetMix(DEFAULT_DRY_WET_MIX)
 	{}
 
-	void prepare(float _nInputChannels, float _sampleRate, int blockSize, float lengthInMs) {
+	void prepare(float _nInputChannels, float _sampleRate, int blockSize, float lengthInMs, float maxLengthInMs = MAX_DELAY_LENGTH) {
 
 		sampleRate = _sampleRate;
 
 		const auto lengthInSamples = static_cast<int>((lengthToSamples(sampleRate, lengthInMs)));
-		delayBufferSize = static_cast<int>((lengthToSamples(sampleRate, MAX_DELAY_LENGTH)));
+		delayBufferSize = delayLineSize(sampleRate, maxLengthInMs);
 
 		ringBuffer = RingBuffer<float>(delayBufferSize);
 
@@ -62,7 +62,7 @@ protected:
 	int delayBufferSize;
 
 	RingBuffer<float> ringBuffer;
-	OnePoleFilter paramFilter;
+	OnePoleFilter<float> paramFilter;
 
 	// Parameters
 	float feedbackGain;
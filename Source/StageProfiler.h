@@ -0,0 +1,158 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+ #include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+ #include <x86intrin.h>
+#endif
+
+// Per-stage cycle counters inside the DSP. Off by default: add
+// SPACE_CHILI_PROFILE=1 to the exporter's preprocessor definitions to build
+// them in. Switched off, the profilers hold nothing and every call compiles
+// to nothing.
+#ifndef SPACE_CHILI_PROFILE
+ #define SPACE_CHILI_PROFILE 0
+#endif
+
+// Cycles on x86 (TSC) and ARM64 (virtual counter), nanoseconds elsewhere.
+// Either way only ratios between stages and builds are meaningful.
+inline uint64_t readCycleCounter()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Cycles spent in each stage of Stage (an enum class ending in count), per
+// block. The audio thread adds up the stages of a block and publishes them
+// when the block ends; any thread can read the last block, the peak and the
+// running total of every stage without stopping it.
+template <typename Stage, bool Enabled = SPACE_CHILI_PROFILE>
+class StageProfiler
+{
+    static constexpr int STAGES = static_cast<int>(Stage::count);
+
+    // Audio thread only
+    std::array<uint64_t, STAGES> block{};
+
+    std::array<std::atomic<uint64_t>, STAGES> lastCycles{};
+    std::array<std::atomic<uint64_t>, STAGES> peakCycles{};
+    std::array<std::atomic<uint64_t>, STAGES> totalCycles{};
+    std::atomic<uint64_t> blockCount{ 0 };
+    std::atomic<bool> resetRequested{ false };
+
+    // Single writer: load and store instead of a locked read-modify-write
+    static void store(std::atomic<uint64_t>& a, uint64_t value) {
+        a.store(value, std::memory_order_relaxed);
+    }
+
+    static uint64_t load(const std::atomic<uint64_t>& a) {
+        return a.load(std::memory_order_relaxed);
+    }
+
+public:
+    static constexpr bool enabled = true;
+
+    // Times its scope into one stage of the current block
+    class Scope
+    {
+        uint64_t& cycles;
+        uint64_t start{ readCycleCounter() };
+
+    public:
+        Scope(uint64_t& c) : cycles(c) {}
+        ~Scope() { cycles += readCycleCounter() - start; }
+    };
+
+    // Publishes the block's stages when it goes out of scope
+    class BlockScope
+    {
+        StageProfiler& profiler;
+
+    public:
+        BlockScope(StageProfiler& p) : profiler(p) {}
+        ~BlockScope() { profiler.endBlock(); }
+    };
+
+    // Audio thread
+    Scope time(Stage stage) {
+        return Scope(block[static_cast<int>(stage)]);
+    }
+
+    // Audio thread
+    BlockScope timeBlock() {
+        return BlockScope(*this);
+    }
+
+    // Audio thread
+    void endBlock() {
+        if (resetRequested.load(std::memory_order_relaxed) && resetRequested.exchange(false, std::memory_order_acquire)) {
+            for (int i = 0; i < STAGES; ++i) {
+                store(peakCycles[i], 0);
+                store(totalCycles[i], 0);
+            }
+            store(blockCount, 0);
+        }
+
+        for (int i = 0; i < STAGES; ++i) {
+            store(lastCycles[i], block[i]);
+            if (block[i] > load(peakCycles[i])) store(peakCycles[i], block[i]);
+            store(totalCycles[i], load(totalCycles[i]) + block[i]);
+            block[i] = 0;
+        }
+        store(blockCount, load(blockCount) + 1);
+    }
+
+    // Any thread. The audio thread clears the counters at its next block end.
+    void reset() {
+        resetRequested.store(true, std::memory_order_release);
+    }
+
+    uint64_t blocks() const { return load(blockCount); }
+    uint64_t last(Stage stage) const { return load(lastCycles[static_cast<int>(stage)]); }
+    uint64_t peak(Stage stage) const { return load(peakCycles[static_cast<int>(stage)]); }
+    uint64_t total(Stage stage) const { return load(totalCycles[static_cast<int>(stage)]); }
+
+    double average(Stage stage) const {
+        auto n = blocks();
+        return n == 0 ? 0.0 : static_cast<double>(total(stage)) / static_cast<double>(n);
+    }
+};
+
+// Profiling compiled out: same interface, no state, no work
+template <typename Stage>
+class StageProfiler<Stage, false>
+{
+public:
+    static constexpr bool enabled = false;
+
+    // The empty destructors make the guards count as used, so the unused
+    // locals holding them do not warn
+    struct Scope { ~Scope() {} };
+    struct BlockScope { ~BlockScope() {} };
+
+    Scope time(Stage) { return {}; }
+    BlockScope timeBlock() { return {}; }
+    void endBlock() {}
+    void reset() {}
+
+    uint64_t blocks() const { return 0; }
+    uint64_t last(Stage) const { return 0; }
+    uint64_t peak(Stage) const { return 0; }
+    uint64_t total(Stage) const { return 0; }
+    double average(Stage) const { return 0.0; }
+};
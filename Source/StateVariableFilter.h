@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include "OnePoleFilter.h"
+
+// Cascaded 2-pole stages, 2 gives 24 dB/oct
+#define SVF_MAX_STAGES  2
+// Highest cutoff as a fraction of the sample rate, keeps tan() finite
+#define SVF_MAX_CUTOFF  0.49f
+
+enum class FilterType { LowPass, HighPass };
+
+// Tone filter slopes. 6 dB/oct is the one-pole pair, the others use SVFBank.
+enum class FilterSlope { DB6 = 0, DB12 = 1, DB24 = 2 };
+
+// Topology-preserving transform state variable filters, one per channel with
+// a shared cutoff. https://cytomic.com/files/dsp/SvfLinearTrapOptimised2.pdf
+// The trapezoidal integrators keep the filter stable however fast the cutoff
+// moves, and a cutoff change is one tan() with the same FREQUENCY_EPSILON
+// caching as OnePoleFilter. Channel states are lanes, so a frame is one
+// fixed-width loop per stage. Stages are Butterworth sections: Q = 0.7071
+// for 12 dB/oct, 0.5412 and 1.3066 for 24 dB/oct.
+template <typename T, int MaxLanes>
+class SVFBank
+{
+    struct Stage {
+        T k{ 1 }, a1{ 1 }, a2{ 0 }, a3{ 0 };
+        alignas(32) std::array<T, MaxLanes> ic1{};
+        alignas(32) std::array<T, MaxLanes> ic2{};
+    };
+
+    std::array<Stage, SVF_MAX_STAGES> stages;
+    int numStages{ 1 };
+    FilterType type{ FilterType::LowPass };
+    float sampleRate{ DEFAULT_SR };
+    float frequency{ -1.0f };
+
+    void updateCoefficients() {
+        auto g = std::tan(static_cast<float>(M_PI) * std::min(frequency / sampleRate, SVF_MAX_CUTOFF));
+        for (auto& stage : stages) {
+            stage.a1 = static_cast<T>(1.0f / (1.0f + g * (g + static_cast<float>(stage.k))));
+            stage.a2 = static_cast<T>(g) * stage.a1;
+            stage.a3 = static_cast<T>(g) * stage.a2;
+        }
+    }
+
+public:
+    void prepare(float sr, FilterType filterType, int stageCount, float f) {
+        sampleRate = sr;
+        type = filterType;
+        setStages(stageCount);
+        frequency = -1.0f;
+        setFrequency(f);
+    }
+
+    // 1 for 12 dB/oct, 2 for 24 dB/oct. Resets the filter state.
+    void setStages(int stageCount) {
+        numStages = std::clamp(stageCount, 1, SVF_MAX_STAGES);
+        if (numStages == 1) {
+            stages[0].k = static_cast<T>(1.0 / 0.70710678);
+        }
+        else {
+            stages[0].k = static_cast<T>(1.0 / 0.54119610);
+            stages[1].k = static_cast<T>(1.0 / 1.30656296);
+        }
+        if (frequency > 0.0f) updateCoefficients();
+        reset();
+    }
+
+    void setFrequency(float f) {
+        if (std::abs(f - frequency) < FREQUENCY_EPSILON) return;
+        frequency = f;
+        updateCoefficients();
+    }
+
+    void reset() {
+        for (auto& stage : stages) {
+            stage.ic1.fill(static_cast<T>(0));
+            stage.ic2.fill(static_cast<T>(0));
+        }
+    }
+
+    // Filter one frame of Lanes channels in place through Stages stages
+    template <int Lanes, int Stages>
+    void process(T* x) {
+        static_assert(Lanes <= MaxLanes && Stages <= SVF_MAX_STAGES, "Too many lanes or stages");
+        for (int s = 0; s < Stages; ++s) {
+            auto& stage = stages[s];
+            for (int lane = 0; lane < Lanes; ++lane) {
+                T v0 = x[lane];
+                T v3 = v0 - stage.ic2[lane];
+                T v1 = stage.a1 * stage.ic1[lane] + stage.a2 * v3;
+                T v2 = stage.ic2[lane] + stage.a2 * stage.ic1[lane] + stage.a3 * v3;
+                stage.ic1[lane] = 2 * v1 - stage.ic1[lane];
+                stage.ic2[lane] = 2 * v2 - stage.ic2[lane];
+                x[lane] = type == FilterType::LowPass ? v2 : v0 - stage.k * v1 - v2;
+            }
+        }
+    }
+};
@@ -2,31 +2,76 @@
 
 #include <array>
 #include <vector>
+#include <algorithm>
 #include "OnePoleFilter.h"
+#include "StateVariableFilter.h"
 #include "Utils.h"
-#include "RingBuffer.h"
+#include "MultiChannelRingBuffer.h"
+#include "SampleStorage.h"
+#include "Interpolation.h"
+#include "CrossfadeHeads.h"
+#include "ChannelLayout.h"
 #include "EnvFollower.h"
 #include "DSPParameters.h"
 #include "FilteredParameter.h"
+#include "ModulationBank.h"
+#include "StageProfiler.h"
 
 using std::vector;
 using std::array;
 
 // Default values
 #define MAX_DELAY_LENGTH			2500.0f
+#define MAX_LR_RATIO				1.25f
+#define MIN_DELAY_SAMPLES			1.0f
 #define DEFAULT_SAMPLE_RATE			44100
 #define DEFAULT_FILTER_FREQUENCY	3.0f
 #define DEFAULT_DUCK_TIME			20.0f
 #define DEFAULT_FILTER_FREQ			3.0f
 
-#define MAX_CHANNELS			2
-#define DEFAULT_INPUT_CHANNELS	2	
+#define DEFAULT_INPUT_CHANNELS	2
 
 #define LEFT	0
 #define RIGHT	1
 
+// Samples per processing stage, see StereoDelay::process()
+#define DELAY_BLOCK_SIZE	64
+
+// Stages of StereoDelay::process(), as profiled by StageProfiler. Tap reads
+// and the crossfade between heads are one pass, see CrossfadeHeads::read().
+enum class DelayStage { input, parameters, taps, feedback, tone, ducking, mix, count };
+
+inline const char* stageName(DelayStage stage) {
+	static const char* names[] = { "input", "parameters", "taps+crossfade", "feedback", "tone", "ducking", "mix" };
+	return names[static_cast<int>(stage)];
+}
+
+// Delay for any layout up to MAX_CHANNELS. Even channels use the left delay
+// time and odd channels the right one, so stereo keeps its L/R behaviour.
+// Ping-pong feeds the summed input into channel 0 and passes the feedback on
+// by pingPongRotation channels (1 is the classic stereo ping-pong).
+// SampleType is float or double; parameters and control values stay float.
+template <typename SampleType>
 struct StereoDelay {
 
+	// Fractional delay interpolation, see Interpolation.h
+	using Interpolator = LinearInterpolation;
+
+	// Longest delay either channel can be set to: the right channel is the
+	// left length scaled by the L/R ratio. Buffers are sized from this.
+	static constexpr float maxDelayLength = MAX_DELAY_LENGTH * MAX_LR_RATIO;
+
+	template <int Lanes, typename Storage>
+	using DelayLine = MultiChannelRingBuffer<SampleType, Lanes, INTERPOLATION_GUARD, Storage>;
+
+	// One line per storage format for a given kernel width
+	template <int Lanes>
+	struct DelayLines {
+		DelayLine<Lanes, SampleType> native;
+		DelayLine<Lanes, Fixed16> fixed;
+		DelayLine<Lanes, Half16> half;
+	};
+
 	StereoDelay() :
 		delayBufferSize(0),
 		pingPong(false),
@@ -34,146 +79,467 @@ struct StereoDelay {
 		highPassFilters(),
 		envFollowers(),
 		feedbackGain(0.0),
-		crossfade(0.0f),
-		crossfadeInc(0.0f),
 		sampleRate(DEFAULT_SAMPLE_RATE),
-		nInputChannels(DEFAULT_INPUT_CHANNELS)
+		nInputChannels(DEFAULT_INPUT_CHANNELS),
+		layout(ChannelLayout::STEREO),
+		storage(DelayStorage::FLOAT32)
 	{}
 
 	void prepare(DSPParameters<float>& params) {
 
-		sampleRate = params["sampleRate"];
-		nInputChannels = params["nChannels"];
-
-		crossfadeInc = (1.0f / (0.05f * sampleRate));
+		sampleRate = params[Param::sampleRate];
+		nInputChannels = params[Param::nChannels];
 
-		const auto lengthInSamples = static_cast<int>((lengthToSamples(sampleRate, params["delayLength"])));
-		delayBufferSize = static_cast<int>((lengthToSamples(sampleRate, MAX_DELAY_LENGTH)));
+		delayBufferSize = delayLineSize(sampleRate, maxDelayLength);
+		maxDelaySize = lengthToSamples(sampleRate, maxDelayLength);
 
-		delaySizeL = lengthInSamples;
-		delaySizeR = lengthInSamples;
-		targetSizeL = delaySizeL;
-		targetSizeR = delaySizeR;
+		lowFreq.prepare(sampleRate, DEFAULT_FILTER_FREQ, params[Param::lowPassFreq]);
+		highFreq.prepare(sampleRate, DEFAULT_FILTER_FREQ, params[Param::highPassFreq]);
+		lowCutoff = lowFreq.read();
+		highCutoff = highFreq.read();
 
-		lowFreq.prepare(sampleRate, DEFAULT_FILTER_FREQ, params["lowPassFreq"]);
-		highFreq.prepare(sampleRate, DEFAULT_FILTER_FREQ, params["highPassFreq"]);
+		// Only the line for the selected kernel width and storage format gets
+		// memory. Storage is reused when it is already large enough, see fits().
+		layout = static_cast<ChannelLayout>(static_cast<int>(params[Param::layout]));
+		channels = outputsFor(layout, static_cast<int>(params[Param::nOutputChannels]));
+		lanes = lanesFor(layout, static_cast<int>(params[Param::nOutputChannels]));
+		storage = static_cast<DelayStorage>(static_cast<int>(params[Param::storage]));
+		withDelayLine(lanes, storage, [this](auto& line) { line.resize(delayBufferSize); });
 
+		// Heads start at the lengths update() would target, so no fade follows
+		auto left = clamp(lengthToSamples(sampleRate, params[Param::leftDelayLength]), MIN_DELAY_SAMPLES, maxDelaySize);
+		auto right = clamp(lengthToSamples(sampleRate, params[Param::rightDelayLength]), MIN_DELAY_SAMPLES, maxDelaySize);
 		for (int channel = 0; channel < MAX_CHANNELS; ++channel) {
-			ringBuffers[channel] = RingBuffer<float>(delayBufferSize);
-			
-			lowPassFilters[channel].prepare(sampleRate, lowFreq.read());
-			highPassFilters[channel].prepare(sampleRate, highFreq.read());
-
-			envFollowers[channel].prepare(sampleRate, DEFAULT_DUCK_TIME, DEFAULT_DUCK_TIME);
+			heads[channel].setCurve(static_cast<CrossfadeCurve>(static_cast<int>(params[Param::crossfadeCurve])));
+			heads[channel].prepare(sampleRate, channel % 2 == LEFT ? left : right);
 		}
+		lowPassFilters.prepare(sampleRate, lowFreq.read());
+		highPassFilters.prepare(sampleRate, highFreq.read());
+		slope = static_cast<FilterSlope>(static_cast<int>(params[Param::filterSlope]));
+		filterInLoop = params[Param::filterInLoop] == 1.0f;
+		lowPassSVF.prepare(sampleRate, FilterType::LowPass, slope == FilterSlope::DB24 ? 2 : 1, lowFreq.read());
+		highPassSVF.prepare(sampleRate, FilterType::HighPass, slope == FilterSlope::DB24 ? 2 : 1, highFreq.read());
+		envFollowers.prepare(sampleRate, DEFAULT_DUCK_TIME, DEFAULT_DUCK_TIME);
+
+		// Lanes past the channel count are never written and must stay silent
+		dry.fill(static_cast<SampleType>(0));
+		wet.fill(static_cast<SampleType>(0));
+
+		pingPong = params[Param::pingPong] == 1.0f;
+		setRotation(static_cast<int>(params[Param::pingPongRotation]));
+		feedbackGain.prepare(sampleRate, DEFAULT_FILTER_FREQ, params[Param::feedback]);
+		mix.prepare(sampleRate, DEFAULT_FILTER_FREQ, params[Param::mix]);
+		duckingAmt.prepare(sampleRate, DEFAULT_FILTER_FREQ, params[Param::ducking]);
+		resetControls();
+	}
 
-		pingPong = params["pingPong"] == 1.0f;
-		feedbackGain.prepare(sampleRate, DEFAULT_FILTER_FREQ, params["feedback"]);
-		mix.prepare(sampleRate, DEFAULT_FILTER_FREQ, params["mix"]);
-		duckingAmt.prepare(sampleRate, DEFAULT_FILTER_FREQ, params["ducking"]);
+	// True when prepare(params) can run without allocating
+	bool fits(DSPParameters<float>& params) {
+		auto size = delayLineSize(params[Param::sampleRate], maxDelayLength);
+		auto result = false;
+		withDelayLine(
+			lanesFor(static_cast<ChannelLayout>(static_cast<int>(params[Param::layout])), static_cast<int>(params[Param::nOutputChannels])),
+			static_cast<DelayStorage>(static_cast<int>(params[Param::storage])),
+			[&](auto& line) { result = line.fits(size); }
+		);
+		return result;
 	}
 
 	void update(DSPParameters<float>& params) {
 
-		pingPong = params["pingPong"] == 1.0;
+		pingPong = params[Param::pingPong] == 1.0;
+		setRotation(static_cast<int>(params[Param::pingPongRotation]));
 
-		if (crossfade == 0.0f) {
-			targetSizeL = lengthToSamples(sampleRate, params["leftDelayLength"]);
-			targetSizeR = lengthToSamples(sampleRate, params["rightDelayLength"]);
+		// New delay times retarget the heads at any time, also mid-fade
+		auto curve = static_cast<CrossfadeCurve>(static_cast<int>(params[Param::crossfadeCurve]));
+		auto left = clamp(lengthToSamples(sampleRate, params[Param::leftDelayLength]), MIN_DELAY_SAMPLES, maxDelaySize);
+		auto right = clamp(lengthToSamples(sampleRate, params[Param::rightDelayLength]), MIN_DELAY_SAMPLES, maxDelaySize);
+		for (int channel = 0; channel < channels; ++channel) {
+			heads[channel].setCurve(curve);
+			heads[channel].setTarget(channel % 2 == LEFT ? left : right);
 		}
-						
-		feedbackGain.setValue(params["feedback"]);
-		mix.setValue(params["mix"]);
 
-		lowFreq.setValue(params["lowPassFreq"]);
-		highFreq.setValue(params["highPassFreq"]);
+		feedbackGain.setValue(params[Param::feedback]);
+		mix.setValue(params[Param::mix]);
+
+		lowFreq.setValue(params[Param::lowPassFreq]);
+		highFreq.setValue(params[Param::highPassFreq]);
+		setSlope(static_cast<FilterSlope>(static_cast<int>(params[Param::filterSlope])));
+		filterInLoop = params[Param::filterInLoop] == 1.0f;
 
-		duckingAmt.setValue(params["ducking"]);
+		duckingAmt.setValue(params[Param::ducking]);
 	}
 
-	void processBlock(float* const* inputBuffer, int numChannels, int numSamples) {
-		for (auto s = 0; s < numSamples; ++s) {
-		
-			auto leftS = inputBuffer[0][s];
-			auto rightS = inputBuffer[1][s];
+	void processBlock(SampleType* const* inputBuffer, int numChannels, int numSamples) {
+		auto profiled = profile.timeBlock();
+		linePeak = 0.0f;
+		if (numChannels < channels) return;
+
+		switch (lanes) {
+		case 1:
+			withStorage(lines1, storage, [&](auto& line) { process<1, false>(line, inputBuffer, numSamples); });
+			break;
+		case 2:
+			if (layout == ChannelLayout::MONO_TO_STEREO) {
+				withStorage(lines2, storage, [&](auto& line) { process<2, true>(line, inputBuffer, numSamples); });
+			}
+			else {
+				withStorage(lines2, storage, [&](auto& line) { process<2, false>(line, inputBuffer, numSamples); });
+			}
+			break;
+		case 4:
+			withStorage(lines4, storage, [&](auto& line) { process<4, false>(line, inputBuffer, numSamples); });
+			break;
+		case 8:
+			withStorage(lines8, storage, [&](auto& line) { process<8, false>(line, inputBuffer, numSamples); });
+			break;
+		default:
+			withStorage(lines12, storage, [&](auto& line) { process<12, false>(line, inputBuffer, numSamples); });
+			break;
+		}
+	}
 
-			auto leftDelayRead = ringBuffers[0].read(delaySizeL);
-			auto rightDelayRead = ringBuffers[1].read(delaySizeR);
+	// Zero the delay line, e.g. once its contents have decayed to silence
+	void clear() {
+		withDelayLine(lanes, storage, [](auto& line) { line.clear(); });
+	}
 
-			if (crossfade == 0.0f) {
-				if ((delaySizeL != targetSizeL) || (delaySizeR != targetSizeR)) {
-					crossfade = crossfadeInc;
-				}
-			}				
-
-			if (crossfade > 0.0f) {
-				float newDelayL = ringBuffers[0].read(targetSizeL);
-				float newDelayR = ringBuffers[1].read(targetSizeR);
-				leftDelayRead = (1.0f - crossfade) * leftDelayRead + crossfade * newDelayL;
-				rightDelayRead = (1.0f - crossfade) * rightDelayRead + crossfade * newDelayR;
-				crossfade += crossfadeInc;
-				if (crossfade > 1.0f) {
-					delaySizeL = targetSizeL;
-					delaySizeR = targetSizeR;
-					crossfade = 0.0f;
-				}
-			}
+	// Longest delay, in samples, that a head reads from or is heading to
+	float longestDelay() const {
+		auto longest = heads[0].longestDelay();
+		for (int channel = 1; channel < channels; ++channel) {
+			longest = std::max(longest, heads[channel].longestDelay());
+		}
+		return longest;
+	}
+
+	// Largest magnitude written to the delay line during the last block
+	float getLinePeak() const {
+		return linePeak;
+	}
+
+	// Cycles per stage, empty unless built with SPACE_CHILI_PROFILE
+	StageProfiler<DelayStage>& getProfile() {
+		return profile;
+	}
+
+protected:
+	template <typename Lines, typename Fn>
+	static void withStorage(Lines& lines, DelayStorage format, Fn&& fn) {
+		switch (format) {
+		case DelayStorage::FIXED16: fn(lines.fixed); break;
+		case DelayStorage::HALF16:  fn(lines.half); break;
+		default:                    fn(lines.native); break;
+		}
+	}
 
-			float leftDelayInput, rightDelayInput;
+	// Calls fn with the delay line used by a kernel width and storage format
+	template <typename Fn>
+	void withDelayLine(int width, DelayStorage format, Fn&& fn) {
+		switch (width) {
+		case 1:  withStorage(lines1, format, fn); break;
+		case 2:  withStorage(lines2, format, fn); break;
+		case 4:  withStorage(lines4, format, fn); break;
+		case 8:  withStorage(lines8, format, fn); break;
+		default: withStorage(lines12, format, fn); break;
+		}
+	}
 
-			auto currentFeedbackGain = feedbackGain.next();
+	// The filters switched to start from silence, so no stale state rings out
+	void setSlope(FilterSlope newSlope) {
+		if (newSlope == slope) return;
+		slope = newSlope;
+		lowPassFilters.reset();
+		highPassFilters.reset();
+		lowPassSVF.setStages(slope == FilterSlope::DB24 ? 2 : 1);
+		highPassSVF.setStages(slope == FilterSlope::DB24 ? 2 : 1);
+	}
 
-			if (pingPong) {
-				ringBuffers[0].write(leftS + rightS + rightDelayRead * currentFeedbackGain);
-				ringBuffers[1].write(leftDelayRead * currentFeedbackGain);
+	// Channel whose echo each channel repeats when ping-ponging. Rotations
+	// that are a multiple of the channel count would feed every channel back
+	// into itself, so they rotate by one instead.
+	void setRotation(int rotation) {
+		rotation %= channels;
+		if (rotation == 0) rotation = 1;
+		for (int channel = 0; channel < channels; ++channel) {
+			rotationSources[channel] = ((channel - rotation) % channels + channels) % channels;
+		}
+	}
 
+	// The block runs as a chain of stages, each one a loop over a sub-block of
+	// at most DELAY_BLOCK_SIZE samples: input -> parameters -> tap read and
+	// crossfade -> feedback write -> tone filters -> ducking -> mix. With the
+	// filters in the loop they run before the feedback write, so every repeat
+	// is filtered again. Scratch
+	// holds interleaved frames of Lanes samples, and the per-channel filter and
+	// envelope states are lanes too, so every stage is a fixed-width loop across
+	// all channels. Sub-blocks are also capped at the shortest integer delay
+	// being read, so no read depends on a sample written in the same sub-block.
+	// MonoInput feeds input channel 0 to every channel (mono to stereo).
+	template <int Lanes, bool MonoInput, typename Line>
+	void process(Line& delayLine, SampleType* const* inputBuffer, int numSamples) {
+		for (int start = 0; start < numSamples; ) {
+			auto n = std::min({ DELAY_BLOCK_SIZE, numSamples - start, maxSubBlockSize() });
+
+			{ auto t = profile.time(DelayStage::input);      readInput<Lanes, MonoInput>(inputBuffer, start, n); }
+			{ auto t = profile.time(DelayStage::parameters); fillParameters(n); }
+			{ auto t = profile.time(DelayStage::taps);       readTaps<Lanes>(delayLine, n); }
+			if (filterInLoop) {
+				{ auto t = profile.time(DelayStage::tone);     applyToneFilters<Lanes>(n); }
+				{ auto t = profile.time(DelayStage::feedback); writeFeedback<Lanes>(delayLine, n); }
 			}
 			else {
-				ringBuffers[0].write(leftS + leftDelayRead * currentFeedbackGain);
-				ringBuffers[1].write(rightS + rightDelayRead * currentFeedbackGain);
+				{ auto t = profile.time(DelayStage::feedback); writeFeedback<Lanes>(delayLine, n); }
+				{ auto t = profile.time(DelayStage::tone);     applyToneFilters<Lanes>(n); }
 			}
+			{ auto t = profile.time(DelayStage::ducking);    applyDucking<Lanes>(n); }
+			{ auto t = profile.time(DelayStage::mix);        applyMix<Lanes>(inputBuffer, start, n); }
 
-			auto currentLowFreq = lowFreq.next();
-			auto currentHighFreq = highFreq.next();
+			start += n;
+		}
+	}
 
-			leftDelayRead  = lowPassFilters[0].updateAndProcess(currentLowFreq, leftDelayRead);
-			rightDelayRead = lowPassFilters[1].updateAndProcess(currentLowFreq, rightDelayRead);
-			leftDelayRead  -= highPassFilters[0].updateAndProcess(currentHighFreq, leftDelayRead);
-			rightDelayRead -= highPassFilters[1].updateAndProcess(currentHighFreq, rightDelayRead);
+	int maxSubBlockSize() const {
+		auto shortest = heads[0].shortestDelay();
+		for (int channel = 1; channel < channels; ++channel) {
+			shortest = std::min(shortest, heads[channel].shortestDelay());
+		}
+		// The newest interpolation tap sits one sample after the integer delay
+		return std::max(1, static_cast<int>(shortest));
+	}
 
-			if (duckingAmt.next() > 0.0f) {
-				auto leftDuckingGain =  envFollowers[0].process(leftS);
-				auto rightDuckingGain = envFollowers[1].process(rightS);
-				leftDelayRead  *= (1.0f - leftDuckingGain * duckingAmt.next());
-				rightDelayRead *= (1.0f - rightDuckingGain * duckingAmt.next());
+	template <int Lanes, bool MonoInput>
+	void readInput(SampleType* const* inputBuffer, int start, int n) {
+		for (int channel = 0; channel < channels; ++channel) {
+			auto input = inputBuffer[MonoInput ? 0 : channel] + start;
+			for (int s = 0; s < n; ++s) {
+				dry[s * Lanes + channel] = input[s];
 			}
+		}
+	}
 
-			inputBuffer[0][s] = leftS * (1.0 - mix.next()) + leftDelayRead * mix.next();
-			inputBuffer[1][s] = rightS * (1.0 - mix.next()) + rightDelayRead * mix.next();
+	// Smoothed parameters are evaluated once per CONTROL_INTERVAL and ramped
+	// linearly in between, as in Chorus, see ModulationBank.h. The filters take
+	// the cutoffs reached at the end of the sub-block.
+	void fillParameters(int n) {
+		if (controls.template isSettled<CONTROL_LANES>() && !isSmoothing()) {
+			std::fill(feedbackRamp.begin(), feedbackRamp.begin() + n, controls[FEEDBACK_LANE]);
+			std::fill(mixRamp.begin(), mixRamp.begin() + n, controls[MIX_LANE]);
+			std::fill(duckingRamp.begin(), duckingRamp.begin() + n, controls[DUCKING_LANE]);
+			controlLeft = 0;
+		}
+		else {
+			rampControls(n);
+		}
+
+		lowCutoff = controls[LOW_CUTOFF_LANE];
+		highCutoff = controls[HIGH_CUTOFF_LANE];
+		// Once the parameter has settled its ramp only runs one way
+		ducking = duckingAmt.isSmoothing() || duckingRamp[0] > 0 || duckingRamp[n - 1] > 0;
+	}
+
+	// Intervals run on across sub-blocks, so the control rate does not depend on
+	// where sub-blocks start
+	void rampControls(int n) {
+		for (int s = 0; s < n; ) {
+			if (controlLeft == 0) {
+				controlTargets = {
+					feedbackGain.advance(CONTROL_INTERVAL), mix.advance(CONTROL_INTERVAL), duckingAmt.advance(CONTROL_INTERVAL),
+					lowFreq.advance(CONTROL_INTERVAL), highFreq.advance(CONTROL_INTERVAL)
+				};
+				controls.template rampTo<CONTROL_LANES>(controlTargets.data(), CONTROL_INTERVAL);
+				controlLeft = CONTROL_INTERVAL;
+			}
+
+			auto k = std::min(controlLeft, n - s);
+			controls.fill(FEEDBACK_LANE, feedbackRamp.data() + s, k);
+			controls.fill(MIX_LANE, mixRamp.data() + s, k);
+			controls.fill(DUCKING_LANE, duckingRamp.data() + s, k);
+			controls.template advance<CONTROL_LANES>(k);
+			s += k;
+			controlLeft -= k;
+
+			// Land exactly on the targets, so settled values do not drift
+			if (controlLeft == 0) controls.reset(controlTargets.data(), CONTROL_LANES);
+		}
+	}
+
+	bool isSmoothing() const {
+		return feedbackGain.isSmoothing() || mix.isSmoothing() || duckingAmt.isSmoothing()
+			|| lowFreq.isSmoothing() || highFreq.isSmoothing();
+	}
+
+	// Start every control ramp at its parameter's current value
+	void resetControls() {
+		controlTargets = { feedbackGain.read(), mix.read(), duckingAmt.read(), lowFreq.read(), highFreq.read() };
+		controls.reset(controlTargets.data(), CONTROL_LANES);
+		controlLeft = 0;
+	}
+
+	// Every active head of a channel is read and summed with its fade gain
+	template <int Lanes, typename Line>
+	void readTaps(Line& delayLine, int n) {
+		for (int channel = 0; channel < channels; ++channel) {
+			heads[channel].read(delayLine, channel, tap.data(), fadeOut.data(), fadeGains.data(), n);
+			for (int s = 0; s < n; ++s) {
+				wet[s * Lanes + channel] = tap[s];
+			}
+		}
+	}
+
+	template <int Lanes, typename Line>
+	void writeFeedback(Line& delayLine, int n) {
+		if (Lanes > 1 && pingPong) {
+			for (int s = 0; s < n; ++s) {
+				auto in = dry.data() + s * Lanes;
+				auto taps = wet.data() + s * Lanes;
+				auto out = feedbackFrames.data() + s * Lanes;
+
+				SampleType sum = 0;
+				for (int lane = 0; lane < Lanes; ++lane) {
+					sum += in[lane];
+					out[lane] = 0;
+				}
+				for (int channel = 0; channel < channels; ++channel) {
+					out[channel] = taps[rotationSources[channel]] * feedbackRamp[s];
+				}
+				out[0] += sum;
+			}
+		}
+		else {
+			for (int s = 0; s < n; ++s) {
+				for (int lane = 0; lane < Lanes; ++lane) {
+					feedbackFrames[s * Lanes + lane] = dry[s * Lanes + lane] + wet[s * Lanes + lane] * feedbackRamp[s];
+				}
+			}
+		}
+		for (int i = 0; i < n * Lanes; ++i) {
+			linePeak = std::max(linePeak, static_cast<float>(std::abs(feedbackFrames[i])));
+		}
+		delayLine.writeFrames(feedbackFrames.data(), n);
+	}
+
+	template <int Lanes>
+	void applyToneFilters(int n) {
+		switch (slope) {
+		case FilterSlope::DB12: applySVFs<Lanes, 1>(n); break;
+		case FilterSlope::DB24: applySVFs<Lanes, 2>(n); break;
+		default: applyOnePoles<Lanes>(n); break;
+		}
+	}
+
+	// 6 dB/oct: the high cut is the one-pole low-pass, the low cut subtracts
+	// a second low-pass
+	template <int Lanes>
+	void applyOnePoles(int n) {
+		lowPassFilters.setFrequency(lowCutoff);
+		highPassFilters.setFrequency(highCutoff);
+
+		for (int s = 0; s < n; ++s) {
+			auto x = wet.data() + s * Lanes;
+			lowPassFilters.template process<Lanes>(x, x);
+			highPassFilters.template process<Lanes>(x, frame.data());
+			for (int lane = 0; lane < Lanes; ++lane) {
+				x[lane] -= frame[lane];
+			}
+		}
+	}
+
+	template <int Lanes, int Stages>
+	void applySVFs(int n) {
+		lowPassSVF.setFrequency(lowCutoff);
+		highPassSVF.setFrequency(highCutoff);
+
+		for (int s = 0; s < n; ++s) {
+			auto x = wet.data() + s * Lanes;
+			lowPassSVF.template process<Lanes, Stages>(x);
+			highPassSVF.template process<Lanes, Stages>(x);
+		}
+	}
+
+	template <int Lanes>
+	void applyDucking(int n) {
+		if (!ducking) return;
+
+		for (int s = 0; s < n; ++s) {
+			envFollowers.template process<Lanes>(dry.data() + s * Lanes, frame.data());
+			for (int lane = 0; lane < Lanes; ++lane) {
+				wet[s * Lanes + lane] *= static_cast<SampleType>(1) - frame[lane] * duckingRamp[s];
+			}
+		}
+	}
+
+	template <int Lanes>
+	void applyMix(SampleType* const* outputBuffer, int start, int n) {
+		for (int s = 0; s < n; ++s) {
+			for (int lane = 0; lane < Lanes; ++lane) {
+				auto i = s * Lanes + lane;
+				wet[i] = dry[i] + (wet[i] - dry[i]) * mixRamp[s];
+			}
+		}
+		for (int channel = 0; channel < channels; ++channel) {
+			auto out = outputBuffer[channel] + start;
+			for (int s = 0; s < n; ++s) {
+				out[s] = wet[s * Lanes + channel];
+			}
 		}
 	}
 
-protected:
 	float sampleRate;
 	int nInputChannels;
 	int delayBufferSize;
-
-	array<RingBuffer<float>, 2> ringBuffers;
-	array<OnePoleFilter, 2> lowPassFilters;
-	array<OnePoleFilter, 2> highPassFilters;
-	array<EnvFollower, 2> envFollowers;
+	float maxDelaySize;
+	float linePeak{ 0.0f };
+
+	ChannelLayout layout;
+	int channels{ 2 };
+	int lanes{ 2 };
+	DelayStorage storage;
+	DelayLines<1> lines1;
+	DelayLines<2> lines2;
+	DelayLines<4> lines4;
+	DelayLines<8> lines8;
+	DelayLines<12> lines12;
+	array<CrossfadeHeads<Interpolator>, MAX_CHANNELS> heads;
+	OnePoleFilterBank<SampleType, MAX_CHANNELS> lowPassFilters;
+	OnePoleFilterBank<SampleType, MAX_CHANNELS> highPassFilters;
+	SVFBank<SampleType, MAX_CHANNELS> lowPassSVF;
+	SVFBank<SampleType, MAX_CHANNELS> highPassSVF;
+	FilterSlope slope{ FilterSlope::DB6 };
+	bool filterInLoop{ false };
+	EnvFollowerBank<SampleType, MAX_CHANNELS> envFollowers;
+	array<int, MAX_CHANNELS> rotationSources{};
+
+	// Scratch for one sub-block, interleaved with a stride of the kernel width
+	using Block = array<SampleType, DELAY_BLOCK_SIZE>;
+	using Frames = array<SampleType, DELAY_BLOCK_SIZE * MAX_CHANNELS>;
+	alignas(32) Frames dry;
+	alignas(32) Frames wet;
+	alignas(32) Frames feedbackFrames;
+	alignas(32) array<SampleType, MAX_CHANNELS> frame;
+	alignas(32) Block tap;
+	alignas(32) Block fadeOut;
+	alignas(32) Block fadeGains;
+	alignas(32) array<float, DELAY_BLOCK_SIZE> feedbackRamp;
+	alignas(32) array<float, DELAY_BLOCK_SIZE> mixRamp;
+	alignas(32) array<float, DELAY_BLOCK_SIZE> duckingRamp;
 
 	// Parameters
-	float delaySizeL;
-	float delaySizeR;
-	float targetSizeL;
-	float targetSizeR;
-	float crossfade;
-	float crossfadeInc;
-	FilteredParameter feedbackGain;
-	FilteredParameter mix;
-	FilteredParameter duckingAmt;
-	FilteredParameter lowFreq;
-	FilteredParameter highFreq;
+	FilteredParameter<float> feedbackGain;
+	FilteredParameter<float> mix;
+	FilteredParameter<float> duckingAmt;
+	FilteredParameter<float> lowFreq;
+	FilteredParameter<float> highFreq;
+	float lowCutoff;
+	float highCutoff;
+	bool ducking{ false };
+
+	// Control-rate ramps of the parameters above, see fillParameters()
+	enum ControlLane { FEEDBACK_LANE, MIX_LANE, DUCKING_LANE, LOW_CUTOFF_LANE, HIGH_CUTOFF_LANE, CONTROL_LANES };
+	ModulationBank<CONTROL_LANES> controls;
+	array<float, CONTROL_LANES> controlTargets{};
+	int controlLeft{ 0 };
 	bool pingPong;
+
+	StageProfiler<DelayStage> profile;
 };
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// Level below which input and delay line contents count as silence (-100 dBFS)
+#define SLEEP_THRESHOLD     0.00001f
+
+// Decides when the effect can stop processing. Once the input has been silent
+// and nothing above SLEEP_THRESHOLD has gone into the delay lines for longer
+// than the longest delay, every sample still in the lines is below the
+// threshold, so the lines can be cleared and processing skipped until the
+// input comes back. Clearing only drops sub-threshold residue, so waking up
+// starts from a clean state without an audible step.
+class TailTracker
+{
+    int quietSamples{ 0 };
+    int window{ 0 };
+    bool sleeping{ false };
+
+public:
+    // Seconds until the echoes of a full scale impulse fall below the
+    // threshold: each pass around the loop scales it by the feedback gain.
+    static double tailSeconds(float feedback, float longestDelayMs, float extraMs = 0.0f) {
+        if (feedback >= 1.0f) return std::numeric_limits<double>::infinity();
+
+        auto echoes = 1.0;
+        if (feedback > 0.0f) {
+            echoes += std::ceil(std::log(SLEEP_THRESHOLD) / std::log(feedback));
+        }
+        return (echoes * longestDelayMs + extraMs) * 0.001;
+    }
+
+    template <typename T>
+    static float peak(const T* const* channels, int numChannels, int numSamples) {
+        float level = 0.0f;
+        for (int channel = 0; channel < numChannels; ++channel) {
+            for (int s = 0; s < numSamples; ++s) {
+                level = std::max(level, static_cast<float>(std::abs(channels[channel][s])));
+            }
+        }
+        return level;
+    }
+
+    // Samples of silence needed before sleeping, at least the longest delay
+    // anything can still be in flight for
+    void setWindow(int samples) {
+        window = samples;
+    }
+
+    void reset() {
+        quietSamples = 0;
+        sleeping = false;
+    }
+
+    bool isSleeping() const {
+        return sleeping;
+    }
+
+    // Call after processing a block. Returns true when the effect has just
+    // gone to sleep and its delay lines should be cleared.
+    bool update(float inputPeak, float linePeak, int numSamples) {
+        if (inputPeak > SLEEP_THRESHOLD || linePeak > SLEEP_THRESHOLD) {
+            quietSamples = 0;
+            return false;
+        }
+
+        quietSamples += numSamples;
+        sleeping = quietSamples > window;
+        return sleeping;
+    }
+};
@@ -10,6 +10,8 @@
 
 #pragma once
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 
 // Utility functions
 template<typename T>
@@ -28,7 +30,7 @@ inline unsigned int nearestPowerOfTwo(int n) {
 
 template<typename T>
 T lerp(T a, T b, T f) {
-	return a * (1.0 - f) + b * f;
+	return a * (static_cast<T>(1) - f) + b * f;
 }
 
 template<typename T>
@@ -38,6 +40,21 @@ T clamp(T val, T minVal, T maxVal) {
 	return val;
 }
 
+// exp(x) as 2^k * 2^r with r in [-0.5, 0.5] and a degree-6 Taylor polynomial
+// for 2^r. Relative error is below 5e-7 for x in [-4, 0], the range one-pole
+// coefficients use, and below 4e-6 over the whole clamped range [-87, 88].
+inline float fastExp(float x) {
+	x = x < -87.0f ? -87.0f : (x > 88.0f ? 88.0f : x);
+	float t = x * 1.44269504f;
+	int k = static_cast<int>(t + (t < 0.0f ? -0.5f : 0.5f));
+	float r = (t - k) * 0.69314718f;
+	float p = 1.0f + r * (1.0f + r * (0.5f + r * (0.16666667f + r * (0.041666668f + r * (0.008333334f + r * 0.0013888889f)))));
+	int32_t bits = (k + 127) << 23;
+	float scale;
+	std::memcpy(&scale, &bits, sizeof(scale));
+	return p * scale;
+}
+
 #define SILENCE 0.000001f
 
 class LogarithmicFader
@@ -73,9 +90,25 @@ public:
         return currentGain;
     }
 
+    // Skip n samples of the fade and return the gain reached
+    float advance(int n) {
+        if (std::abs(currentGain - targetGain) > 0.0001f) {
+            currentGain *= std::pow(multiplier, static_cast<float>(n));
+            if ((multiplier > 1.0f && currentGain >= targetGain) || (multiplier < 1.0f && currentGain <= targetGain)) {
+                currentGain = targetGain;
+            }
+        }
+        return currentGain;
+    }
+
     float read() {
         return currentGain;
     }
+
+    // Faded out and not fading back in. Does not advance the fade.
+    bool isSilent() {
+        return currentGain <= SILENCE && targetGain <= SILENCE;
+    }
 };
 
 class SlewLimiter
@@ -0,0 +1,121 @@
+// Measures the noise the 16-bit delay line formats add, for the figures in
+// Source/SampleStorage.h. Needs no JUCE:
+//
+//   c++ -std=c++17 -O2 -I Source Tools/StorageNoise.cpp -o StorageNoise
+//   ./StorageNoise
+//
+// Round trip: uniform white noise at several levels through encodeBlock() and
+// decodeBlock(), the path the ring buffers take. Error is reported in dBFS and
+// relative to the signal.
+// Feedback: a delay loop of one block with gain g, requantizing on every
+// pass, against the same loop in float. Fixed16 noise is absolute and half16
+// noise relative to the signal, so their growth is measured that way.
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "SampleStorage.h"
+
+#define NOISE_SAMPLES   (1 << 20)
+#define LOOP_LENGTH     1024
+#define LOOP_PASSES     2000
+// Loop input level, low enough that g = 0.99 stays inside the fixed16 headroom
+#define LOOP_INPUT      0.05f
+
+static double toDB(double x)
+{
+    return 20.0 * std::log10(x);
+}
+
+static std::vector<float> whiteNoise(float peak, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(-peak, peak);
+    std::vector<float> x(NOISE_SAMPLES);
+    for (auto& s : x) s = uniform(rng);
+    return x;
+}
+
+static double rms(const std::vector<float>& x)
+{
+    double sum = 0.0;
+    for (auto s : x) sum += static_cast<double>(s) * s;
+    return std::sqrt(sum / x.size());
+}
+
+template <typename Storage>
+static double roundTripError(const std::vector<float>& x)
+{
+    std::vector<Storage> stored(x.size());
+    std::vector<float> y(x.size());
+    encodeBlock(x.data(), stored.data(), static_cast<int>(x.size()));
+    decodeBlock(stored.data(), y.data(), static_cast<int>(y.size()));
+
+    double sum = 0.0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        double e = static_cast<double>(y[i]) - x[i];
+        sum += e * e;
+    }
+    return std::sqrt(sum / x.size());
+}
+
+// Each pass adds fresh noise to the loop and feeds the stored line back with
+// gain g. Returns the RMS difference from the float loop after it settles,
+// absolute or relative to the loop signal.
+template <typename Storage>
+static double loopError(float gain, bool relative)
+{
+    auto input = whiteNoise(LOOP_INPUT, 7);
+    std::vector<float> reference(LOOP_LENGTH, 0.0f), quantised(LOOP_LENGTH, 0.0f);
+    std::vector<Storage> stored(LOOP_LENGTH);
+
+    double sum = 0.0, signal = 0.0;
+    int count = 0;
+    for (int pass = 0; pass < LOOP_PASSES; ++pass) {
+        for (int i = 0; i < LOOP_LENGTH; ++i) {
+            auto x = input[(pass * LOOP_LENGTH + i) % NOISE_SAMPLES];
+            reference[i] = x + gain * reference[i];
+            quantised[i] = x + gain * quantised[i];
+        }
+        encodeBlock(quantised.data(), stored.data(), LOOP_LENGTH);
+        decodeBlock(stored.data(), quantised.data(), LOOP_LENGTH);
+
+        if (pass >= LOOP_PASSES / 2) {
+            for (int i = 0; i < LOOP_LENGTH; ++i) {
+                double e = static_cast<double>(quantised[i]) - reference[i];
+                sum += e * e;
+                signal += static_cast<double>(reference[i]) * reference[i];
+                ++count;
+            }
+        }
+    }
+    return std::sqrt(relative ? sum / signal : sum / count);
+}
+
+int main()
+{
+    std::printf("Round trip, uniform white noise\n");
+    std::printf("%10s %12s %12s %12s %12s\n", "level dBFS", "fixed16 dBFS", "fixed16 rel", "half16 dBFS", "half16 rel");
+    for (float level : { 0.0f, -20.0f, -40.0f, -60.0f }) {
+        auto x = whiteNoise(std::pow(10.0f, level / 20.0f), 1);
+        auto signal = rms(x);
+        auto fixed = roundTripError<Fixed16>(x);
+        auto half = roundTripError<Half16>(x);
+        std::printf("%10.0f %12.1f %12.1f %12.1f %12.1f\n", level,
+            toDB(fixed), toDB(fixed / signal), toDB(half), toDB(half / signal));
+    }
+
+    std::printf("\nFeedback loop, error growth against one round trip\n");
+    std::printf("%10s %12s %12s\n", "gain", "fixed16 dB", "half16 dB");
+    auto once = whiteNoise(LOOP_INPUT, 7);
+    auto fixedOnce = roundTripError<Fixed16>(once);
+    auto halfOnce = roundTripError<Half16>(once) / rms(once);
+    for (float gain : { 0.5f, 0.9f, 0.99f }) {
+        std::printf("%10.2f %12.1f %12.1f\n", gain,
+            toDB(loopError<Fixed16>(gain, false) / fixedOnce), toDB(loopError<Half16>(gain, true) / halfOnce));
+    }
+    std::printf("\nExpected growth 1 / sqrt(1 - g^2): 0.50 %.1f dB, 0.90 %.1f dB, 0.99 %.1f dB\n",
+        toDB(1.0 / std::sqrt(1.0 - 0.25)), toDB(1.0 / std::sqrt(1.0 - 0.81)), toDB(1.0 / std::sqrt(1.0 - 0.9801)));
+    return 0;
+}